@@ -3,12 +3,16 @@
 //	would be called the i-node).
 //
 //	The file header is used to locate where on disk the 
-//	file's data is stored.  We implement this as a fixed size
-//	table of pointers -- each entry in the table points to the 
-//	disk sector containing that portion of the file data
-//	(in other words, there are no indirect or doubly indirect 
-//	blocks). The table size is chosen so that the file header
-//	will be just big enough to fit in one disk sector, 
+//	file's data is stored.  We implement this as a table of
+//	extents -- each entry in the table gives the first disk sector
+//	and the length of a run of consecutive sectors holding the next
+//	portion of the file data.  The first NumDirectExtents entries
+//	fit in the header's own disk sector; a file in more pieces than
+//	that has a single indirect sector for the rest.
+//
+//	Data blocks are allocated a run at a time, looking for a free
+//	run long enough for all of the file so that reading it needs no
+//	seeks (and, with SynchDisk::ReadSectors, one disk request).
 //
 //      Unlike in a real system, we do not keep track of file permissions, 
 //	ownership, last modification date, etc., in the file header. 
@@ -29,12 +33,45 @@
 #include "system.h"
 #include "filehdr.h"
 
+//----------------------------------------------------------------------
+// FindFreeRun
+// 	Return the first sector of the first run of at least "want" free
+//	sectors, setting "*length" to "want"; or, if there is no such
+//	run, of the longest free run, setting "*length" to its length.
+//	Returns -1 if there are no free sectors at all.
+//----------------------------------------------------------------------
+
+static int
+FindFreeRun(BitMap *freeMap, int want, int *length)
+{
+    int best = -1, bestLength = 0;
+    int start, end;
+
+    for (start = 0; start < NumSectors; start = end + 1) {
+	while (start < NumSectors && freeMap->Test(start))
+	    start++;
+	for (end = start; end < NumSectors && !freeMap->Test(end); end++)
+	    if (end - start + 1 == want) {
+		*length = want;
+		return start;
+	    }
+	if (end - start > bestLength) {
+	    best = start;
+	    bestLength = end - start;
+	}
+    }
+    *length = bestLength;
+    return best;
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
-//	Allocate data blocks for the file out of the map of free disk blocks.
+//	Allocate data blocks for the file out of the map of free disk blocks,
+//	in as few runs of consecutive sectors as we can: the first free run
+//	that holds all that is still needed, else the longest free run.
 //	Return false if there are not enough free blocks to accomodate
-//	the new file.
+//	the new file, or they are in more than MaxExtents pieces.
 //
 //	"freeMap" is the bit map of free disk sectors
 //	"fileSize" is the bit map of free disk sectors
@@ -43,13 +80,32 @@
 bool
 FileHeader::Allocate(BitMap *freeMap, int fileSize)
 { 
+    int left, start, length, i;
+
     numBytes = fileSize;
     numSectors  = divRoundUp(fileSize, SectorSize);
+    numExtents = 0;
+    indirectSector = -1;
     if (freeMap->NumClear() < numSectors)
 	return false;		// not enough space
 
-    for (int i = 0; i < numSectors; i++)
-	dataSectors[i] = freeMap->Find();
+    for (left = numSectors; left > 0; left -= length) {
+	start = FindFreeRun(freeMap, left, &length);
+	if (numExtents == (int) MaxExtents) {
+	    Deallocate(freeMap);	// too scattered; give it all back
+	    return false;
+	}
+	for (i = 0; i < length; i++)
+	    freeMap->Mark(start + i);
+	extents[numExtents].start = start;
+	extents[numExtents].length = length;
+	numExtents++;
+    }
+    if (numExtents > (int) NumDirectExtents &&
+	(indirectSector = freeMap->Find()) == -1) {
+	Deallocate(freeMap);
+	return false;
+    }
     return true;
 }
 
@@ -63,9 +119,15 @@ FileHeader::Allocate(BitMap *freeMap, int fileSize)
 void 
 FileHeader::Deallocate(BitMap *freeMap)
 {
-    for (int i = 0; i < numSectors; i++) {
-	ASSERT(freeMap->Test((int) dataSectors[i]));  // ought to be marked!
-	freeMap->Clear((int) dataSectors[i]);
+    for (int i = 0; i < numExtents; i++) {
+	for (int j = 0; j < extents[i].length; j++) {
+	    ASSERT(freeMap->Test(extents[i].start + j));  // ought to be marked!
+	    freeMap->Clear(extents[i].start + j);
+	}
+    }
+    if (indirectSector != -1) {
+	ASSERT(freeMap->Test(indirectSector));
+	freeMap->Clear(indirectSector);
     }
 }
 
@@ -80,6 +142,9 @@ void
 FileHeader::FetchFrom(int sector)
 {
     synchDisk->ReadSector(sector, (char *)this);
+    if (indirectSector != -1)
+	synchDisk->ReadSector(indirectSector,
+			      (char *) &extents[NumDirectExtents]);
 }
 
 //----------------------------------------------------------------------
@@ -93,6 +158,9 @@ void
 FileHeader::WriteBack(int sector)
 {
     synchDisk->WriteSector(sector, (char *)this); 
+    if (indirectSector != -1)
+	synchDisk->WriteSector(indirectSector,
+			       (char *) &extents[NumDirectExtents]);
 }
 
 //----------------------------------------------------------------------
@@ -108,7 +176,15 @@ FileHeader::WriteBack(int sector)
 int
 FileHeader::ByteToSector(int offset)
 {
-    return(dataSectors[offset / SectorSize]);
+    int block = offset / SectorSize;
+
+    for (int i = 0; i < numExtents; i++) {
+	if (block < extents[i].length)
+	    return(extents[i].start + block);
+	block -= extents[i].length;
+    }
+    ASSERT(false);			// past the end of the file
+    return -1;
 }
 
 //----------------------------------------------------------------------
@@ -135,11 +211,12 @@ FileHeader::Print()
     char *data = new char[SectorSize];
 
     printf("FileHeader contents.  File size: %d.  File blocks:\n", numBytes);
-    for (i = 0; i < numSectors; i++)
-	printf("%d ", dataSectors[i]);
+    for (i = 0; i < numExtents; i++)
+	printf("%d-%d ", extents[i].start,
+	       extents[i].start + extents[i].length - 1);
     printf("\nFile contents:\n");
     for (i = k = 0; i < numSectors; i++) {
-	synchDisk->ReadSector(dataSectors[i], data);
+	synchDisk->ReadSector(ByteToSector(i * SectorSize), data);
         for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
 	    if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 		printf("%c", data[j]);
@@ -19,19 +19,30 @@
 #include "disk.h"
 #include "bitmap.h"
 
-#define NumDirect 	((SectorSize - 2 * sizeof(int)) / sizeof(int))
-#define MaxFileSize 	(NumDirect * SectorSize)
+// A run of consecutive disk sectors holding consecutive file data.
+struct Extent {
+    int start;				// first disk sector
+    int length;				// number of sectors
+};
+
+#define NumDirectExtents 	((SectorSize - 4 * sizeof(int)) / sizeof(Extent))
+#define NumIndirectExtents 	(SectorSize / sizeof(Extent))
+#define MaxExtents 	(NumDirectExtents + NumIndirectExtents)
+#define MaxFileSize 	(NumSectors * SectorSize)
 
 // The following class defines the Nachos "file header" (in UNIX terms,  
 // the "i-node"), describing where on disk to find all of the data in the file.
-// The file header is organized as a simple table of pointers to
-// data blocks. 
+// The file header is organized as a table of extents, each a run of
+// consecutive data blocks, in file order.
 //
 // The file header data structure can be stored in memory or on disk.
-// When it is on disk, it is stored in a single sector -- this means
-// that we assume the size of this data structure to be the same
-// as one disk sector.  Without indirect addressing, this
-// limits the maximum file length to just under 4K bytes.
+// When it is on disk, it is stored in a single sector holding the
+// first NumDirectExtents extents, plus (for a file in more pieces than
+// that) an indirect sector holding up to NumIndirectExtents more.  In
+// memory the two sectors are laid out one after the other, so the
+// extents form a single table.  Since the allocator looks for free
+// runs long enough to hold the whole file, most files have one extent,
+// and the file length is limited by the free space on the disk.
 //
 // There is no constructor; rather the file header can be initialized
 // by allocating blocks for the file (if it is a new file), or by
@@ -59,10 +70,15 @@ class FileHeader {
     void Print();			// Print the contents of the file.
 
   private:
+    // The first sector's worth is the on-disk header
     int numBytes;			// Number of bytes in the file
     int numSectors;			// Number of data sectors in the file
-    int dataSectors[NumDirect];		// Disk sector numbers for each data 
-					// block in the file
+    int numExtents;			// Number of extents in use
+    int indirectSector;			// Disk sector holding the extents
+					// past NumDirectExtents, or -1
+    Extent extents[MaxExtents];		// The file's extents; the ones past
+					// NumDirectExtents are the indirect
+					// sector
 };
 
 #endif // FILEHDR_H
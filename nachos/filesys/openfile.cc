@@ -84,6 +84,33 @@ OpenFile::Write(void *into, size_t numBytes)
    return result;
 }
 
+//----------------------------------------------------------------------
+// TransferRuns
+// 	Read or write sectors firstSector through lastSector of a file,
+//	into or out of "buf", with one disk request for each run of them
+//	that lies in consecutive disk sectors.
+//----------------------------------------------------------------------
+
+static void
+TransferRuns(FileHeader *hdr, int firstSector, int lastSector, char *buf,
+	     bool writing)
+{
+  int i, run, sector;
+  char *at;
+
+  for (i = firstSector; i <= lastSector; i += run) {
+    sector = hdr->ByteToSector(i * SectorSize);
+    for (run = 1; (i + run <= lastSector) &&
+	   (hdr->ByteToSector((i + run) * SectorSize) == sector + run); run++)
+      ;
+    at = &buf[(i - firstSector) * SectorSize];
+    if (writing)
+      synchDisk->WriteSectors(sector, run, at);
+    else
+      synchDisk->ReadSectors(sector, run, at);
+  }
+}
+
 //----------------------------------------------------------------------
 // OpenFile::ReadAt/WriteAt
 // 	Read/write a portion of a file, starting at "position".
@@ -103,6 +130,8 @@ OpenFile::Write(void *into, size_t numBytes)
 //	   in the data that will be modified, and write back all the full
 //	   or partial sectors that are part of the request.
 //
+//	Sectors that lie next to each other on disk go in one request.
+//
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
 //	"numBytes" -- the number of bytes to transfer
@@ -114,7 +143,7 @@ int
 OpenFile::ReadAt(void *into, size_t numBytes, int position)
 {
   int fileLength = hdr->FileLength();
-  int i, firstSector, lastSector, numSectors;
+  int firstSector, lastSector, numSectors;
   char *buf;
 
   if ((numBytes <= 0) || (position >= fileLength))
@@ -130,9 +159,7 @@ OpenFile::ReadAt(void *into, size_t numBytes, int position)
 
   // read in all the full and partial sectors that we need
   buf = new char[numSectors * SectorSize];
-  for (i = firstSector; i <= lastSector; i++)	
-    synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
-			  &buf[(i - firstSector) * SectorSize]);
+  TransferRuns(hdr, firstSector, lastSector, buf, false);
 
   // copy the part we want
   memcpy(into, &buf[position - (firstSector * SectorSize)], numBytes);
@@ -144,7 +171,7 @@ int
 OpenFile::WriteAt(void *from, size_t numBytes, int position)
 {
   int fileLength = hdr->FileLength();
-  int i, firstSector, lastSector, numSectors;
+  int firstSector, lastSector, numSectors;
   bool firstAligned, lastAligned;
   char *buf;
 
@@ -175,9 +202,7 @@ OpenFile::WriteAt(void *from, size_t numBytes, int position)
   memcpy(&buf[position - (firstSector * SectorSize)], from, numBytes);
 
   // write modified sectors back
-  for (i = firstSector; i <= lastSector; i++)	
-    synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
-			   &buf[(i - firstSector) * SectorSize]);
+  TransferRuns(hdr, firstSector, lastSector, buf, true);
   delete [] buf;
   return static_cast<int> (numBytes);
 }
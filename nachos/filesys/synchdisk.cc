@@ -5,10 +5,22 @@
 //	the disk providing a synchronous interface (requests wait until
 //	the request completes).
 //
-//	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	Each requesting thread sleeps until the interrupt handler wakes
+//	it.  Because the physical disk can only handle one operation at
+//	a time, requests made while it is busy wait in a queue, and the
+//	interrupt handler starts the next one as each finishes.  Which
+//	one is next depends on diskSchedPolicy: the oldest (DISK_FIFO),
+//	the nearest at or above the head, wrapping round to the lowest
+//	(CLOOK), or the nearest in the direction the head is sweeping,
+//	turning at the last request (SCAN).
+//
+//	Recently used sectors are kept in a buffer cache, so that reading
+//	one again (directory and file header sectors, above all, which
+//	are fetched on every Open and Create) costs no disk time.  In
+//	write-back mode, writes are held in the cache too, so repeated
+//	small writes to one sector cost one disk write between them.
+//	A lock protects the cache; it is not held during disk transfers,
+//	so a thread waiting for the disk does not hold up hits.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -18,6 +30,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -33,6 +46,24 @@ DiskRequestDone (size_t arg)
     disk->RequestDone();
 }
 
+//----------------------------------------------------------------------
+// DiskFlushDue, DiskFlusher
+// 	The write-back timer's interrupt handler, and the flusher
+//	thread, again as C routines.
+//----------------------------------------------------------------------
+
+static void
+DiskFlushDue (size_t arg)
+{
+    ((SynchDisk *) arg)->FlushDue();
+}
+
+static void
+DiskFlusher (size_t arg)
+{
+    ((SynchDisk *) arg)->Flusher();
+}
+
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
 // 	Initialize the synchronous interface to the physical disk, in turn
@@ -40,13 +71,57 @@ DiskRequestDone (size_t arg)
 //
 //	"name" -- UNIX file name to be used as storage for the disk data
 //	   (usually, "DISK")
+//	"cacheSectors" -- how many sectors the buffer cache holds
+//	"delay" -- in write-back mode, how long a sector may stay dirty
+//	   before the flusher writes it out; 0 for write-through
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk(char* name)
+SynchDisk::SynchDisk(char* name, int cacheSectors, int delay)
 {
-    semaphore = new KernelSemaphore("synch disk", 0);
+    int i;
+
     lock = new Lock("synch disk lock");
+    cacheReady = new Condition((char *)"synch disk cache");
     disk = new Disk(name, DiskRequestDone, (size_t) this);
+    active = queue = NULL;
+    headSector = 0;
+    sweepUp = true;
+
+    numCached = cacheSectors;
+    cache = (numCached > 0) ? new CacheEntry[numCached] : NULL;
+    for (i = 0; i < NumSectors; i++)
+	where[i] = NULL;
+    mru = lru = NULL;
+    runs = NULL;
+    for (i = 0; i < numCached; i++) {	// all free, in any order
+	cache[i].sector = -1;
+	cache[i].dirty = cache[i].busy = false;
+	cache[i].prev = lru;
+	cache[i].next = NULL;
+	if (lru != NULL)
+	    lru->next = &cache[i];
+	else
+	    mru = &cache[i];
+	lru = &cache[i];
+    }
+
+    flushDelay = delay;
+    numDirty = 0;
+    flushPending = false;
+    flushWake = NULL;
+    if (flushDelay > 0) {
+	Thread *t = new Thread();
+	IntStatus oldLevel;
+
+	ASSERT(numCached > 0);		// write-back needs the cache
+	flushWake = new KernelSemaphore((char *)"disk flusher", 0);
+	t->SetName((char *)"disk flusher");
+	t->Fork(DiskFlusher, (size_t) this);
+
+	oldLevel = interrupt->SetLevel(IntOff);
+	scheduler->ReadyToRun(t);
+	(void) interrupt->SetLevel(oldLevel);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -57,9 +132,222 @@ SynchDisk::SynchDisk(char* name)
 
 SynchDisk::~SynchDisk()
 {
+    int i;
+
+    for (i = 0; i < numCached; i++)	// Nachos is halting: no more
+	if (cache[i].dirty)		// interrupts, so no waiting
+	    disk->WriteAtHalt(cache[i].sector, cache[i].data);
     delete disk;
+    delete cacheReady;
     delete lock;
-    delete semaphore;
+    delete [] cache;
+    delete flushWake;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Transfer
+// 	Read or write one sector, and return once the disk has done it.
+//	If the disk is busy, the request waits in the queue until the
+//	interrupt handler picks it.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Transfer(int sectorNumber, char* data, bool writing, int count)
+{
+    DiskRequest request;
+    DiskRequest **tail;
+    IntStatus oldLevel;
+
+    request.sector = sectorNumber;
+    request.count = count;
+    request.data = data;
+    request.writing = writing;
+    request.waiter = currentThread;
+    request.queued = stats->totalTicks;
+    request.next = NULL;
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    if (active == NULL) {
+	Start(&request);
+    } else {
+	for (tail = &queue; *tail != NULL; tail = &(*tail)->next)
+	    ;
+	*tail = &request;
+	stats->numDiskRequestsQueued++;
+    }
+    currentThread->Sleep();		// until RequestDone
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Start
+// 	Hand a request to the disk.  Interrupts are off.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Start(DiskRequest *request)
+{
+    int tracks = request->sector / SectorsPerTrack -
+		 headSector / SectorsPerTrack;
+
+    stats->numDiskSeekTracks += (tracks < 0) ? -tracks : tracks;
+    if (request->sector != headSector)
+	sweepUp = (request->sector > headSector);
+    headSector = request->sector;
+    active = request;
+    if (request->writing)
+	disk->WriteRequest(request->sector, request->data, request->count);
+    else
+	disk->ReadRequest(request->sector, request->data, request->count);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::PickNext
+// 	Remove and return the queued request to start next, by the disk
+//	scheduling policy, or NULL if the queue is empty.  Among requests
+//	for the same sector the oldest goes first.  Interrupts are off.
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::PickNext()
+{
+    DiskRequest **best = NULL, **p;
+    int sector;
+
+    if (queue == NULL)
+	return NULL;
+
+    switch (diskSchedPolicy) {
+      case DISK_FIFO:
+	best = &queue;
+	break;
+      case CLOOK:			// lowest at or above the head,
+	for (p = &queue; *p != NULL; p = &(*p)->next) {	// else lowest
+	    sector = (*p)->sector;
+	    if (best == NULL ||
+		((sector >= headSector) == ((*best)->sector >= headSector) ?
+		 sector < (*best)->sector : sector >= headSector))
+		best = p;
+	}
+	break;
+      case SCAN:			// nearest ahead; turn if none
+	for (p = &queue; *p != NULL; p = &(*p)->next) {
+	    sector = (*p)->sector;
+	    if (sweepUp ? sector < headSector : sector > headSector)
+		continue;
+	    if (best == NULL ||
+		(sweepUp ? sector < (*best)->sector :
+		 sector > (*best)->sector))
+		best = p;
+	}
+	if (best == NULL) {
+	    sweepUp = !sweepUp;
+	    return PickNext();
+	}
+	break;
+    }
+
+    DiskRequest *request = *best;
+    *best = request->next;
+    return request;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::CacheGet
+// 	Return the cache entry for a sector, claiming the least recently
+//	used idle entry if it is not cached (and, if "fill", reading the
+//	sector into it).  A dirty victim is written out first.  The entry
+//	becomes the most recently used.  The lock must be held; it is
+//	let go while waiting for busy entries, for runs covering the
+//	sector, and for the disk.
+//----------------------------------------------------------------------
+
+CacheEntry *
+SynchDisk::CacheGet(int sectorNumber, bool fill)
+{
+    CacheEntry *entry;
+
+    for (;;) {
+	if (RunCovers(sectorNumber, 1)) {
+	    cacheReady->Wait(lock);
+	    continue;
+	}
+	entry = where[sectorNumber];
+	if (entry != NULL) {
+	    if (entry->busy) {
+		cacheReady->Wait(lock);
+		continue;
+	    }
+	    if (fill)
+		stats->numDiskCacheHits++;
+	    CacheTouch(entry);
+	    return entry;
+	}
+
+	for (entry = lru; entry != NULL && entry->busy; entry = entry->prev)
+	    ;
+	if (entry == NULL) {		// all in use: wait for one
+	    cacheReady->Wait(lock);
+	    continue;
+	}
+	if (entry->dirty) {		// the world may change meanwhile,
+	    WriteBack(entry);		// so look again afterwards
+	    continue;
+	}
+
+	if (entry->sector >= 0)
+	    where[entry->sector] = NULL;
+	entry->sector = sectorNumber;
+	where[sectorNumber] = entry;
+	CacheTouch(entry);
+	if (fill) {
+	    stats->numDiskCacheMisses++;
+	    entry->busy = true;
+	    lock->Release();
+	    Transfer(sectorNumber, entry->data, false);
+	    lock->Acquire();
+	    entry->busy = false;
+	    cacheReady->Broadcast(lock);
+	}
+	return entry;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::RunCovers
+// 	Return whether a run being transferred overlaps any of the
+//	"count" sectors from sectorNumber on.  The lock must be held.
+//----------------------------------------------------------------------
+
+bool
+SynchDisk::RunCovers(int sectorNumber, int count)
+{
+    for (DiskRun *run = runs; run != NULL; run = run->next)
+	if (run->first < sectorNumber + count &&
+	    sectorNumber < run->first + run->count)
+	    return true;
+    return false;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::CacheTouch
+// 	Move an entry to the most recently used end of the list.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::CacheTouch(CacheEntry *entry)
+{
+    if (entry == mru)
+	return;
+    entry->prev->next = entry->next;	// unlink; entry != mru, so prev
+    if (entry->next != NULL)		// is not NULL
+	entry->next->prev = entry->prev;
+    else
+	lru = entry->prev;
+    entry->prev = NULL;
+    entry->next = mru;
+    mru->prev = entry;
+    mru = entry;
 }
 
 //----------------------------------------------------------------------
@@ -74,9 +362,15 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
+    CacheEntry *entry;
+
+    if (numCached == 0) {
+	Transfer(sectorNumber, data, false);
+	return;
+    }
+    lock->Acquire();
+    entry = CacheGet(sectorNumber, true);
+    memcpy(data, entry->data, SectorSize);
     lock->Release();
 }
 
@@ -92,20 +386,226 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
+    CacheEntry *entry;
+
+    if (numCached == 0) {
+	Transfer(sectorNumber, data, true);
+	return;
+    }
+    lock->Acquire();			// a whole sector: no need to read it
+    entry = CacheGet(sectorNumber, false);
+    memcpy(entry->data, data, SectorSize);
+    if (flushDelay > 0) {		// write-back: the disk can wait
+	if (entry->dirty) {
+	    stats->numDiskWritesAbsorbed++;
+	} else {
+	    entry->dirty = true;
+	    numDirty++;
+	}
+	if (!flushPending) {
+	    flushPending = true;
+	    interrupt->Schedule(DiskFlushDue, (size_t) this, flushDelay,
+				DiskInt);
+	}
+    } else {
+	entry->busy = true;
+	lock->Release();
+	Transfer(sectorNumber, entry->data, true);
+	lock->Acquire();
+	entry->busy = false;
+	cacheReady->Broadcast(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors/WriteSectors
+// 	Read or write "count" consecutive sectors in one disk request,
+//	returning only once it is done.
+//
+//	"sectorNumber" -- the first disk sector
+//	"count" -- the number of sectors
+//	"data" -- the buffer, "count" sectors long
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectors(int sectorNumber, int count, char* data)
+{
+    if (count == 1)
+	ReadSector(sectorNumber, data);
+    else
+	TransferRun(sectorNumber, count, data, false);
+}
+
+void
+SynchDisk::WriteSectors(int sectorNumber, int count, char* data)
+{
+    if (count == 1)
+	WriteSector(sectorNumber, data);
+    else
+	TransferRun(sectorNumber, count, data, true);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::TransferRun
+// 	Transfer a run of sectors straight between the disk and "data".
+//	While it is in progress the run is listed in "runs", so the cache
+//	does not take on any of its sectors and no other run overlaps it.
+//	Sectors of the run already in the cache are kept busy meanwhile,
+//	so nobody else reads or writes them, and are made to agree with
+//	the transfer: a write copies the new data into them (and so
+//	cleans them), and a read takes the cache's copy of any that are
+//	dirty, since it is newer than the disk's.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::TransferRun(int sectorNumber, int count, char* data, bool writing)
+{
+    CacheEntry *entry, **mine;
+    DiskRun run, **p;
+    int i;
+
+    if (numCached == 0) {
+	Transfer(sectorNumber, data, writing, count);
+	return;
+    }
+
+    lock->Acquire();
+    for (i = 0; i < count; ) {		// wait until none is busy
+	entry = where[sectorNumber + i];
+	if ((entry != NULL && entry->busy) ||
+	    (i == 0 && RunCovers(sectorNumber, count))) {
+	    cacheReady->Wait(lock);
+	    i = 0;			// the others may have changed
+	} else
+	    i++;
+    }
+    run.first = sectorNumber;
+    run.count = count;
+    run.next = runs;
+    runs = &run;
+    mine = new CacheEntry *[count];	// the entries we make busy
+    for (i = 0; i < count; i++) {
+	if ((entry = mine[i] = where[sectorNumber + i]) == NULL)
+	    continue;
+	entry->busy = true;
+	if (writing) {
+	    memcpy(entry->data, data + i * SectorSize, SectorSize);
+	    if (entry->dirty) {
+		entry->dirty = false;
+		numDirty--;
+	    }
+	}
+    }
+    lock->Release();
+
+    Transfer(sectorNumber, data, writing, count);
+
+    lock->Acquire();
+    for (i = 0; i < count; i++) {
+	if ((entry = mine[i]) == NULL)
+	    continue;
+	if (!writing && entry->dirty)
+	    memcpy(data + i * SectorSize, entry->data, SectorSize);
+	entry->busy = false;
+    }
+    for (p = &runs; *p != &run; p = &(*p)->next)
+	;
+    *p = run.next;
+    delete [] mine;
+    cacheReady->Broadcast(lock);
     lock->Release();
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Wake up the thread waiting for the disk
+//	request to finish, and start the next queued request.
 //----------------------------------------------------------------------
 
 void
 SynchDisk::RequestDone()
-{ 
-    semaphore->V();
+{
+    DiskRequest *done = active;
+    unsigned int latency = stats->totalTicks - done->queued;
+
+    if (done->writing)
+	stats->diskWriteLatency.RecordDatum((int) latency);
+    else
+	stats->diskReadLatency.RecordDatum((int) latency);
+    scheduler->ReadyToRun(done->waiter);
+
+    active = NULL;
+    if ((done = PickNext()) != NULL)
+	Start(done);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteBack
+// 	Write a dirty cache entry to the disk.  The lock must be held; it
+//	is let go during the write, while the entry is busy.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteBack(CacheEntry *entry)
+{
+    ASSERT(entry->dirty && !entry->busy);
+    entry->busy = true;
+    lock->Release();
+    Transfer(entry->sector, entry->data, true);
+    lock->Acquire();
+    entry->busy = false;
+    entry->dirty = false;
+    numDirty--;
+    stats->numSectorsFlushed++;
+    cacheReady->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Sync
+// 	Write every dirty sector in the cache to the disk, in increasing
+//	sector order so that the head sweeps across the disk once.
+//	Return only after they have all been written.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Sync()
+{
+    int i;
+
+    lock->Acquire();
+    for (i = 0; i < NumSectors && numDirty > 0; i++) {
+	while (where[i] != NULL && where[i]->busy)
+	    cacheReady->Wait(lock);
+	if (where[i] != NULL && where[i]->dirty)
+	    WriteBack(where[i]);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::FlushDue
+// 	Interrupt handler for the write-back delay: wake the flusher.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::FlushDue()
+{
+    flushPending = false;
+    flushWake->V();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Flusher
+// 	The flusher thread: each time the write-back delay expires,
+//	write out everything that is dirty.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Flusher()
+{
+    for (;;) {
+	flushWake->P();
+	Sync();
+    }
 }
@@ -25,11 +25,62 @@
 //
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
-// returning.
+// returning.  Requests from different threads wait in a queue while the
+// disk is busy, and are sent to it in the order the disk scheduling
+// policy (-dsched) picks: arrival order, C-LOOK, or SCAN.
+//
+// It also keeps a buffer cache of recently used sectors, replaced in
+// least-recently-used order, so that a read of a cached sector returns
+// at once without a disk request.  Writes go through to the disk, and
+// leave the new contents in the cache -- unless the cache is in
+// write-back mode, when a write only marks the cached sector dirty.
+// Dirty sectors are written out, in sector order, by a flusher thread
+// some time after the first of them was dirtied, when they are evicted,
+// on Sync, and as Nachos halts.
+
+// One cached sector.  Entries are kept on a list ordered by last use.
+class CacheEntry {
+  public:
+    int sector;				// disk sector held, or -1
+    bool dirty;				// newer than the disk copy
+    bool busy;				// being read or written: wait
+    CacheEntry *prev;			// more recently used
+    CacheEntry *next;			// less recently used
+    char data[SectorSize];
+};
+
+// One request waiting for, or using, the disk.
+class DiskRequest {
+  public:
+    int sector;				// the first of
+    int count;				// ... this many
+    char *data;
+    bool writing;
+    Thread *waiter;			// sleeps until the request is done
+    unsigned int queued;		// when it was made
+    DiskRequest *next;			// in the queue, in arrival order
+};
+
+// A run of sectors being transferred around the cache (see
+// SynchDisk::TransferRun).  The cache may not take on any of them, nor
+// another run overlap them, until it is done.
+class DiskRun {
+  public:
+    int first;
+    int count;
+    DiskRun *next;
+};
+
 class SynchDisk {
   public:
-    SynchDisk(char* name);    		// Initialize a synchronous disk,
-					// by initializing the raw Disk.
+    SynchDisk(char* name, int cacheSectors = 0, int flushDelay = 0);
+					// Initialize a synchronous disk,
+					// by initializing the raw Disk,
+					// with a buffer cache of
+					// "cacheSectors" sectors (none if 0),
+					// in write-back mode if "flushDelay"
+					// (the ticks a sector may stay dirty)
+					// is not 0
     ~SynchDisk();			// De-allocate the synch disk data
     
     void ReadSector(int sectorNumber, char* data);
@@ -39,17 +90,63 @@ class SynchDisk {
     					// Disk::ReadRequest/WriteRequest and
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
+
+    void ReadSectors(int sectorNumber, int count, char* data);
+    void WriteSectors(int sectorNumber, int count, char* data);
+					// The same, for "count" consecutive
+					// sectors in a single disk request.
+					// Runs bypass the cache, apart from
+					// keeping it consistent.
+
+    void Sync();			// Write every dirty cached sector to
+					// the disk, returning once done
     
     void RequestDone();			// Called by the disk device interrupt
 					// handler, to signal that the
 					// current disk operation is complete.
 
+    void FlushDue();			// Called when the flush delay expires
+    void Flusher();			// Body of the flusher thread
+
   private:
     Disk *disk;		  		// Raw disk device
-    KernelSemaphore *semaphore; 	// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
+    DiskRequest *active;		// request the disk is working on
+    DiskRequest *queue;			// requests waiting for the disk
+    int headSector;			// sector of the last request started
+    bool sweepUp;			// SCAN direction
+
+    Lock *lock;		  		// Protects the cache
+    Condition *cacheReady;		// signalled when an entry stops
+					// being busy
+
+    int numCached;			// size of the buffer cache
+    CacheEntry *cache;			// the cache entries
+    CacheEntry *where[NumSectors];	// entry holding each sector, or NULL
+    CacheEntry *mru, *lru;		// ends of the use-ordered list
+    DiskRun *runs;			// runs being transferred
+
+    int flushDelay;			// write-back delay, or 0 for
+					// write-through
+    int numDirty;			// dirty cache entries
+    bool flushPending;			// the flush delay is running
+    KernelSemaphore *flushWake;		// the flusher sleeps on this
+
+    void Transfer(int sectorNumber, char* data, bool writing,
+		  int count = 1);	// queue a request and wait for it
+    void TransferRun(int sectorNumber, int count, char* data,
+		     bool writing);	// the same, keeping the cache
+					// consistent
+    void Start(DiskRequest *request);	// send a request to the disk
+    DiskRequest *PickNext();		// dequeue the next request to start
+
+    void WriteBack(CacheEntry *entry);	// write a dirty entry to the disk
+    CacheEntry *CacheGet(int sectorNumber, bool fill);
+					// the entry for a sector, read from
+					// the disk first if "fill"
+    void CacheTouch(CacheEntry *entry);	// make an entry most recently used
+    bool RunCovers(int sectorNumber, int count);
+					// do any runs being transferred
+					// overlap these sectors?
 };
 
 #endif // SYNCHDISK_H
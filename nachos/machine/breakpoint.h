@@ -48,6 +48,7 @@ class BreakpointSet {
 			const enum BreakpointType type);
   bool queryBreakpoint(const int address, const int length,
 		       const enum BreakpointType type, int &addr);
+  bool IsEmpty() const { return count == 0; }
 };
 
 #endif /* _MACHINE_BREAKPOINT_H */
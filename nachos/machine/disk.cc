@@ -104,59 +104,92 @@ PrintSector (bool writing, int sector, char *data)
 
 //----------------------------------------------------------------------
 // Disk::ReadRequest/WriteRequest
-// 	Simulate a request to read/write a single disk sector
+// 	Simulate a request to read/write a disk sector, or a run of them
 //	   Do the read/write immediately to the UNIX file
 //	   Set up an interrupt handler to be called later,
 //	      that will notify the caller when the simulator says
 //	      the operation has completed.
 //
 //	Note that a disk only allows an entire sector to be read/written,
-//	not part of a sector.
+//	not part of a sector.  A run of consecutive sectors, even across
+//	tracks, is one request with one interrupt at the end.
 //
-//	"sectorNumber" -- the disk sector to read/write
+//	"sectorNumber" -- the (first) disk sector to read/write
 //	"data" -- the bytes to be written, the buffer to hold the incoming bytes
+//	"numSectors" -- how many consecutive sectors
 //----------------------------------------------------------------------
 
 void
-Disk::ReadRequest(int sectorNumber, char* data)
+Disk::ReadRequest(int sectorNumber, char* data, int numSectors)
 {
-  int ticks = ComputeLatency(sectorNumber, false);
+  int ticks = ComputeRunLatency(sectorNumber, numSectors, false);
 
   ASSERT(!active);				// only one request at a time
-  ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+  ASSERT((sectorNumber >= 0) && (numSectors >= 1) &&
+	 (sectorNumber + numSectors <= NumSectors));
 
-  DEBUG( DB_DISK , "Reading from sector %d\n", sectorNumber);
+  DEBUG( DB_DISK , "Reading from sector %d (%d)\n", sectorNumber, numSectors);
   Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-  Read(fileno, data, SectorSize);
+  Read(fileno, data, SectorSize * numSectors);
   if (DebugIsEnabled("disk"))
-    PrintSector(false, sectorNumber, data);
+    for (int i = 0; i < numSectors; i++)
+      PrintSector(false, sectorNumber + i, data + i * SectorSize);
 
   active = true;
-  UpdateLast(sectorNumber);
+  UpdateLastRun(sectorNumber, numSectors, ticks);
   stats->numDiskReads++;
+  if (numSectors > 1) {
+    stats->numDiskRunRequests++;
+    stats->numDiskRunSectors += numSectors;
+  }
   interrupt->Schedule(DiskDone, (size_t) this, ticks, DiskInt);
 }
 
 void
-Disk::WriteRequest(int sectorNumber, char* data)
+Disk::WriteRequest(int sectorNumber, char* data, int numSectors)
 {
-    int ticks = ComputeLatency(sectorNumber, true);
+    int ticks = ComputeRunLatency(sectorNumber, numSectors, true);
 
     ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((sectorNumber >= 0) && (numSectors >= 1) &&
+	   (sectorNumber + numSectors <= NumSectors));
     
-    DEBUG( DB_DISK , "Writing to sector %d\n", sectorNumber);
+    DEBUG( DB_DISK , "Writing to sector %d (%d)\n", sectorNumber,
+	   numSectors);
     Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    WriteFile(fileno, data, SectorSize * numSectors);
     if (DebugIsEnabled("disk"))
-	PrintSector(true, sectorNumber, data);
+	for (int i = 0; i < numSectors; i++)
+	    PrintSector(true, sectorNumber + i, data + i * SectorSize);
     
     active = true;
-    UpdateLast(sectorNumber);
+    UpdateLastRun(sectorNumber, numSectors, ticks);
     stats->numDiskWrites++;
+    if (numSectors > 1) {
+	stats->numDiskRunRequests++;
+	stats->numDiskRunSectors += numSectors;
+    }
     interrupt->Schedule(DiskDone, (size_t) this, ticks, DiskInt);
 }
 
+//----------------------------------------------------------------------
+// Disk::WriteAtHalt
+// 	Write a sector straight to the UNIX file, with no latency and no
+//	interrupt.  Only for use as Nachos halts, to save what a
+//	write-back cache still holds; "active" is not checked, since a
+//	request in progress is never going to complete anyway.
+//----------------------------------------------------------------------
+
+void
+Disk::WriteAtHalt(int sectorNumber, char* data)
+{
+    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    DEBUG( DB_DISK , "Writing to sector %d at halt\n", sectorNumber);
+    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+    WriteFile(fileno, data, SectorSize);
+    stats->numDiskWrites++;
+}
+
 //----------------------------------------------------------------------
 // Disk::HandleInterrupt()
 // 	Called when it is time to invoke the disk interrupt handler,
@@ -258,6 +291,54 @@ Disk::ComputeLatency(int newSector, bool writing)
   return(seek + rotation + RotationTime);
 }
 
+//----------------------------------------------------------------------
+// Disk::ComputeRunLatency()
+// 	Return how long it will take to read/write "numSectors" sectors
+//	from newSector on.  The first sector costs what ComputeLatency
+//	says and the rest of its track one RotationTime each; each later
+//	track costs a one-track seek, the rotational delay to the first
+//	sector wanted, and one RotationTime per sector.
+//
+//	Any track that is wanted whole is transferred through the track
+//	buffer: the disk starts at whichever sector comes under the head
+//	first, so there is no rotational delay, just one revolution.
+//----------------------------------------------------------------------
+
+int
+Disk::ComputeRunLatency(int newSector, int numSectors, bool writing)
+{
+  int sector = newSector, left = numSectors;
+  int onTrack = min(left, SectorsPerTrack - sector % SectorsPerTrack);
+  int ticks, rotation, now;
+
+  if (numSectors == 1)
+    return ComputeLatency(newSector, writing);
+
+  if (onTrack == SectorsPerTrack) {
+    ticks = TimeToSeek(sector, &rotation);
+    ticks += rotation + SectorsPerTrack * RotationTime;
+  } else
+    ticks = ComputeLatency(sector, writing) + (onTrack - 1) * RotationTime;
+  sector += onTrack;
+  left -= onTrack;
+
+  while (left > 0) {			// on to the next track
+    onTrack = min(left, SectorsPerTrack);
+    now = stats->totalTicks + ticks + SeekTime;
+    rotation = (now % RotationTime == 0) ? 0 :
+	       RotationTime - now % RotationTime;
+    if (onTrack < SectorsPerTrack)
+      rotation += ModuloDiff(sector, (now + rotation) / RotationTime) *
+		  RotationTime;
+    ticks += SeekTime + rotation + onTrack * RotationTime;
+    sector += onTrack;
+    left -= onTrack;
+  }
+
+  DEBUG( DB_DISK , "Request latency = %d (%d sectors)\n", ticks, numSectors);
+  return ticks;
+}
+
 //----------------------------------------------------------------------
 // Disk::UpdateLast
 //   	Keep track of the most recently requested sector.  So we can know
@@ -275,3 +356,23 @@ Disk::UpdateLast(int newSector)
     lastSector = newSector;
     DEBUG( DB_DISK , "Updating last sector = %d, %d\n", lastSector, bufferInit);
 }
+
+//----------------------------------------------------------------------
+// Disk::UpdateLastRun
+//   	The same, for a run of sectors that will take "ticks" to
+//	transfer: the head ends up over the run's last track, and that
+//	track started being loaded into the track buffer as the head
+//	reached it.
+//----------------------------------------------------------------------
+
+void
+Disk::UpdateLastRun(int newSector, int numSectors, int ticks)
+{
+    int last = newSector + numSectors - 1;
+
+    UpdateLast(newSector);
+    if (last / SectorsPerTrack != newSector / SectorsPerTrack)
+	bufferInit = stats->totalTicks + ticks -
+		     (last % SectorsPerTrack + 1) * RotationTime;
+    lastSector = last;
+}
@@ -62,12 +62,19 @@ class Disk {
 					// every time a request completes.
     ~Disk();				// Deallocate the disk.
     
-    void ReadRequest(int sectorNumber, char* data);
-    					// Read/write an single disk sector.
-					// These routines send a request to 
-    					// the disk and return immediately.
+    void ReadRequest(int sectorNumber, char* data, int numSectors = 1);
+    					// Read/write a run of "numSectors"
+					// consecutive disk sectors (usually
+					// one).  These routines send a request
+					// to the disk and return immediately.
     					// Only one request allowed at a time!
-    void WriteRequest(int sectorNumber, char* data);
+    void WriteRequest(int sectorNumber, char* data, int numSectors = 1);
+
+    void WriteAtHalt(int sectorNumber, char* data);
+					// Write a sector with no simulated
+					// time and no interrupt, as the
+					// machine stops (cf. a disk's
+					// power-fail flush)
 
     void HandleInterrupt();		// Interrupt handler, invoked when
 					// disk request finishes.
@@ -76,6 +83,9 @@ class Disk {
     					// Return how long a request to 
 					// newSector will take: 
 					// (seek + rotational delay + transfer)
+    int ComputeRunLatency(int newSector, int numSectors, bool writing);
+					// ... and a request for a run of
+					// sectors starting at newSector
 
   private:
     int fileno;				// UNIX file number for simulated disk 
@@ -90,6 +100,7 @@ class Disk {
     int TimeToSeek(int newSector, int *rotate); // time to get to the new track
     int ModuloDiff(int to, int from);        // # sectors between to and from
     void UpdateLast(int newSector);
+    void UpdateLastRun(int newSector, int numSectors, int ticks);
 };
 
 #endif // DISK_H
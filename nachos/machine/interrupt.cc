@@ -26,6 +26,7 @@
 #include "interrupt.h"
 #include "system.h"
 #include "nachos_dsui.h"
+#include <limits.h>
 
 // String definitions for debugging messages
 
@@ -48,7 +49,12 @@ Interrupt::Interrupt()
   yieldOnReturn = false;
   status        = SystemMode;
   needResched   = false;
-  pending.setComparator (interruptOrder);
+  maxPending    = 16;
+  numPending    = 0;
+  pending       = new PendingInterrupt *[maxPending];
+  nextSeq       = 0;
+  nextDue       = UINT_MAX;
+  freePending   = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -68,8 +74,16 @@ Interrupt::setNeedResched()
 
 Interrupt::~Interrupt()
 {
-  while (!pending.IsEmpty())
-    pending.Remove();
+  PendingInterrupt *toFree;
+
+  while (numPending > 0)
+    delete Pop();
+  delete [] pending;
+  while (freePending != NULL) {
+    toFree = freePending;
+    freePending = toFree->next;
+    delete toFree;
+  }
 }
 
 //----------------------------------------------------------------------
@@ -177,8 +191,9 @@ Interrupt::OneTick()
 					// (interrupt handlers run with
 					// interrupts disabled)
 
-    while (HandleIfDue(false))		// Check & Handle pending interrupts
-	;
+    if (nextDue <= stats->totalTicks)	// nothing can be due before the
+	while (HandleIfDue(false))	// heap head; skip the check until
+	    ;				// then
 
     ChangeLevel(IntOn);			// re-enable interrupts
     // if the timer device handler asked
@@ -195,6 +210,51 @@ Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::TicksUntilDue
+// 	Return the number of user instructions that can be executed, each
+//	followed by a OneTick, before one of those OneTicks would do more
+//	than advance the clock -- that is, until an interrupt comes due or
+//	a pending context switch is taken.  Used by Machine::RunBlock to
+//	size a block so that it sees exactly the interrupt timing of the
+//	one-instruction-at-a-time simulation.
+//----------------------------------------------------------------------
+int
+Interrupt::TicksUntilDue()
+{
+    PendingInterrupt *next;
+
+    if (yieldOnReturn || needResched)
+	return 1;
+
+    next = Head();
+    if (next == NULL)
+	return INT_MAX;
+    if (next->when <= stats->totalTicks + UserTick)
+	return 1;
+    return (next->when - stats->totalTicks) / UserTick;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::ChargeUserTicks
+// 	Advance simulated time by "count" user instructions, exactly as
+//	"count" calls to OneTick would, but without looking for pending
+//	interrupts.  The caller guarantees (via TicksUntilDue) that none
+//	of those ticks makes an interrupt due.
+//----------------------------------------------------------------------
+void
+Interrupt::ChargeUserTicks(int count)
+{
+    ASSERT(status == UserMode);
+
+    stats->totalTicks += count * UserTick;
+    stats->userTicks += count * UserTick;
+    if (currentThread) {
+	currentThread->procStats->totalTicks += count * UserTick;
+	currentThread->procStats->userTicks += count * UserTick;
+    }
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -232,8 +292,7 @@ Interrupt::Idle()
     DEBUG( (char *)DB_INTERRUPT , (char *)"Machine idling; checking for interrupts.\n");
     status = IdleMode;
     if (HandleIfDue(true)) {
-	PendingInterrupt *toOccur =
-	  static_cast<PendingInterrupt *>(pending.Head());
+	PendingInterrupt *toOccur = Head();
 	when = toOccur->when;
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
@@ -275,7 +334,8 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: take a record from the free pool and push it
+//	on the binary heap of pending interrupts.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -294,14 +354,15 @@ Interrupt::Schedule(VoidFunctionPtr handler, size_t arg, unsigned int fromNow,
   IntStatus oldLevel;
   unsigned int when = stats->totalTicks + fromNow;
 
-  PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
-  
+  PendingInterrupt *toOccur;
+
   DEBUG( (char *)DB_INTERRUPT , (char *)"Scheduling interrupt handler the %s at time = %u\n", 
 	intTypeNames[type], when);
   ASSERT(fromNow > 0);
   
   oldLevel = SetLevel (IntOff);
-  pending.Insert(toOccur);
+  toOccur = NewPending(handler, arg, when, type);
+  Push(toOccur);
   SetLevel (oldLevel);
 }
 
@@ -331,23 +392,22 @@ Interrupt::HandleIfDue(bool advanceClock)
     if (DebugIsEnabled((char *)"interrupt"))
 	DumpState();
  
-    toOccur = static_cast<PendingInterrupt *>(pending.Head());
-    when = toOccur->when;
-    
+    toOccur = Head();
     if (toOccur == NULL)		// no pending interrupts
 	return false;			 
+    when = toOccur->when;
 
     if (when > stats->totalTicks) {
         return advanceClock;
     } else {
 	/* Remove the interrupt we peeked at when we set the value of toOccur
 	   above, because it is time to handle the interrupt */
-	(void) pending.Remove();
+	(void) Pop();
     }
 
     // Check if there is nothing more to do, and if so, quit
-    if (status == IdleMode && toOccur->type == TimerInt && pending.IsEmpty()) {
-	pending.Insert(toOccur);
+    if (status == IdleMode && toOccur->type == TimerInt && numPending == 0) {
+	Push(toOccur);
 	return false;
     }
     DEBUG((char *) DB_INTERRUPT ,(char *) "Invoking interrupt handler for the %s at time %u\n", 
@@ -369,24 +429,118 @@ Interrupt::HandleIfDue(bool advanceClock)
     (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = false;
-    delete toOccur;
-    if (pending.IsEmpty()) {
+    FreePending(toOccur);
+    if (numPending == 0) {
 	return false;
     } else {
-	PendingInterrupt *next =
-	  static_cast<PendingInterrupt *>(pending.Head());
-	return next->when == when;
+	return Head()->when == when;
     }
 }
 
 //----------------------------------------------------------------------
 // interruptOrder
-// 	Determine in which order two interrupts should occur.
+// 	Determine in which order two interrupts should occur.  Interrupts
+//	due at the same time fire in the order they were scheduled.
 //----------------------------------------------------------------------
 bool
 interruptOrder (void *int1, void *int2)
 {
-  return ((PendingInterrupt *) int1)->when < ((PendingInterrupt *) int2)->when;
+  PendingInterrupt *a = (PendingInterrupt *) int1;
+  PendingInterrupt *b = (PendingInterrupt *) int2;
+
+  if (a->when != b->when)
+    return a->when < b->when;
+  return (int) (a->seq - b->seq) < 0;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Push
+// 	Add an interrupt to the pending heap, sifting it up past any
+//	entry that should fire after it, and refresh the cached due tick.
+//----------------------------------------------------------------------
+void
+Interrupt::Push(PendingInterrupt *toOccur)
+{
+    int i, parent;
+
+    if (numPending == maxPending) {
+	PendingInterrupt **bigger = new PendingInterrupt *[maxPending * 2];
+	for (i = 0; i < numPending; i++)
+	    bigger[i] = pending[i];
+	delete [] pending;
+	pending = bigger;
+	maxPending *= 2;
+    }
+
+    for (i = numPending++; i > 0; i = parent) {
+	parent = (i - 1) / 2;
+	if (!interruptOrder(toOccur, pending[parent]))
+	    break;
+	pending[i] = pending[parent];
+    }
+    pending[i] = toOccur;
+    nextDue = pending[0]->when;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Pop
+// 	Remove and return the interrupt that is due first, and refresh
+//	the cached due tick.
+//----------------------------------------------------------------------
+PendingInterrupt *
+Interrupt::Pop()
+{
+    PendingInterrupt *first, *last;
+    int i, child;
+
+    ASSERT(numPending > 0);
+    first = pending[0];
+    last = pending[--numPending];
+    for (i = 0; (child = 2 * i + 1) < numPending; i = child) {
+	if (child + 1 < numPending &&
+	    interruptOrder(pending[child + 1], pending[child]))
+	    child++;
+	if (!interruptOrder(pending[child], last))
+	    break;
+	pending[i] = pending[child];
+    }
+    if (numPending > 0)
+	pending[i] = last;
+    nextDue = numPending > 0 ? pending[0]->when : UINT_MAX;
+    return first;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::NewPending, Interrupt::FreePending
+// 	Recycle PendingInterrupt records through a free pool, so the
+//	steady stream of timer and device interrupts does not go through
+//	the heap allocator on every Schedule.
+//----------------------------------------------------------------------
+PendingInterrupt *
+Interrupt::NewPending(VoidFunctionPtr handler, size_t arg, unsigned int when,
+		      IntType type)
+{
+    PendingInterrupt *toOccur = freePending;
+
+    if (toOccur == NULL) {
+	toOccur = new PendingInterrupt(handler, arg, when, type);
+    } else {
+	freePending = toOccur->next;
+	toOccur->handler = handler;
+	toOccur->arg = arg;
+	toOccur->when = when;
+	toOccur->type = type;
+	toOccur->next = NULL;
+    }
+    toOccur->seq = nextSeq++;
+    return toOccur;
+}
+
+void
+Interrupt::FreePending(PendingInterrupt *toOccur)
+{
+    toOccur->next = freePending;
+    freePending = toOccur;
 }
 
 //----------------------------------------------------------------------
@@ -417,7 +571,8 @@ Interrupt::DumpState()
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending.Mapcar(PrintPending);
+    for (int i = 0; i < numPending; i++)	// heap order, not firing order
+	PrintPending((size_t) pending[i]);
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
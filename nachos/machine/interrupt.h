@@ -73,6 +73,8 @@ struct PendingInterrupt {
   size_t arg;			// The argument to the function.
   unsigned int when;		// When the interrupt is supposed to fire
   IntType type;			// for debugging
+  unsigned int seq;		// Schedule order, breaks ties in "when"
+  PendingInterrupt *next;	// link while on the free pool
 
   // Initialize an interrupt that will occur in the future.
   // "func" is the procedure to call when the interrupt occurs.
@@ -81,7 +83,8 @@ struct PendingInterrupt {
   // "kind" is the hardware device that generated the interrupt
   PendingInterrupt(VoidFunctionPtr func, size_t param, unsigned int time,
 		   IntType kind)
-    : handler(func), arg(param), when(time), type(kind) { }
+    : handler(func), arg(param), when(time), type(kind), seq(0),
+      next(NULL) { }
 };
 
 // A function for determining PendingInterrupt order
@@ -132,10 +135,22 @@ class Interrupt {
 
   void OneTick();       		// Advance simulated time
 
+  int TicksUntilDue();			// How many user instructions can
+					// run before OneTick has work to do
+  void ChargeUserTicks(int count);	// Advance simulated time for
+					// "count" user instructions, none
+					// of which may make anything due
+
  private:
   IntStatus level;		// are interrupts enabled or disabled?
-  SortedList pending;		// the list of interrupts scheduled
-				// to occur in the future
+  PendingInterrupt **pending;	// binary min-heap of interrupts
+				// scheduled to occur in the future
+  int numPending;		// entries in use in "pending"
+  int maxPending;		// allocated size of "pending"
+  unsigned int nextSeq;		// stamp for the next Schedule call
+  unsigned int nextDue;		// "when" of the heap head, or UINT_MAX
+				// if nothing is pending
+  PendingInterrupt *freePending;// pool of records to reuse
   bool inHandler;		// true if we are running an interrupt handler
   bool yieldOnReturn;		// true if we are to context switch
 				// on return from the interrupt handler
@@ -150,6 +165,14 @@ class Interrupt {
   void ChangeLevel(IntStatus now);      // SetLevel, without advancing the
                                         // simulated time
 
+  PendingInterrupt *Head()		// next interrupt due, or NULL
+    { return numPending > 0 ? pending[0] : NULL; }
+  void Push(PendingInterrupt *toOccur);	// add to the heap
+  PendingInterrupt *Pop();		// remove and return the heap head
+  PendingInterrupt *NewPending(VoidFunctionPtr handler, size_t arg,
+			       unsigned int when, IntType type);
+  void FreePending(PendingInterrupt *toOccur);
+
 };
 
 #endif // _MACHINE_INTERRRUPT_H
@@ -72,6 +72,15 @@ Machine::Machine(bool debug)
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
 
+    // Nothing has been decoded yet
+    decodeCache = new Instruction[MemorySize / 4];
+    decodeValid = new bool[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+	decodeValid[i] = false;
+    pendingTicks = 0;
+    FlushTranslations();
+    trapped = false;
+
 #ifdef USE_TLB
     // Create the TLB
     tlb = new TranslationEntry[TLBSize];
@@ -95,6 +104,8 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
     delete [] mainMemory;
+    delete [] decodeCache;
+    delete [] decodeValid;
     if (tlb != NULL)
         delete [] tlb;
 }
@@ -116,15 +127,45 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
 
     DEBUG( (char *)DB_MACHINE , (char *)"Exception: %s\n", exceptionNames[which]);
     
+    // If we are in the middle of a block, the instructions before this
+    // one have already run, so the kernel must see their ticks
+    if (pendingTicks > 0) {
+	interrupt->ChargeUserTicks(pendingTicks);
+	pendingTicks = 0;
+    }
+
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
     oldStatus =  interrupt->getStatus();
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
     interrupt->setStatus(oldStatus);
+    trapped = true;			// set last, since the handler may
+					// have run other threads' blocks
 }
 
 
+//----------------------------------------------------------------------
+// Machine::InvalidateFrame
+// 	Discard the predecoded instructions of a physical frame.  The
+//	kernel must call this whenever it changes the contents of a frame
+//	behind the simulator's back (page in, page out, copy-on-write),
+//	since those writes do not go through WriteMem.  The frame may be
+//	the one RunBlock is executing from, so the block ends after the
+//	current instruction.
+//
+//	"frame" -- the physical page number whose contents changed
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateFrame(int frame)
+{
+    ASSERT((frame >= 0) && (frame < NumPhysPages));
+    for (int i = 0; i < InstrsPerPage; i++)
+	decodeValid[frame * InstrsPerPage + i] = false;
+    trapped = true;
+}
+
 //----------------------------------------------------------------------
 // Machine::DumpState
 // 	Print the user program's CPU state.  We might print the contents
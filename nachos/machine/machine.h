@@ -43,6 +43,8 @@
 #define NumPhysPages    128
 #define MemorySize 	(NumPhysPages * PageSize)
 #define TLBSize		4		// if there is a TLB, make it small
+#define InstrsPerPage	(PageSize / 4)	// instruction words in one frame
+#define XlateCacheSize	64		// slots in the host translation cache
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -108,6 +110,22 @@ class Instruction {
                      // Immediates are sign-extended.
 };
 
+// The following class defines one slot of the translation cache that
+// the simulator keeps in front of the page table.  It is not part of the
+// simulated hardware: it only remembers where a recently translated
+// virtual page of the current address space lives in host memory, so
+// that repeated accesses to it can skip Machine::Translate.
+
+class XlateCacheEntry {
+  public:
+    unsigned int vpn;		// virtual page held here; NoXlate if none
+    TranslationEntry *entry;	// the page table entry it was taken from
+    char *frame;		// the page's first byte in mainMemory
+    bool writable;		// stores may use it (no copy-on-write)
+};
+
+#define NoXlate		((unsigned int) -1)
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -140,6 +158,34 @@ class Machine {
 
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+    void RunBlock(Instruction *instr);
+				// Run a straight-line run of user
+				// instructions, charging ticks per block
+    void RunBatch(Instruction *instr);
+				// Run user instructions up to the next
+				// interrupt deadline, charging ticks once
+    void ExecuteInstruction(Instruction *instr);
+				// Carry out an already fetched instruction
+    bool FetchInstruction(int addr, Instruction *instr);
+				// Fetch the instruction at virtual address
+				// "addr", decoding it only if the word is
+				// not already in the predecode cache.
+    bool FetchWord(int addr, unsigned int *word);
+				// Translate "addr" for an instruction fetch
+				// and make sure its word is predecoded
+    void DecodeWord(unsigned int word);
+				// Refill one slot of the predecode cache
+    char *CachedTranslate(int virtAddr, int size, bool writing);
+				// Translate through the translation cache,
+				// or return NULL if Translate is needed
+    void FlushTranslation(unsigned int vpn);
+				// Forget the cached translation of a page
+				// whose mapping is about to change
+    void FlushTranslations();	// Forget all cached translations, e.g.
+				// when the page table is switched
+    void InvalidateFrame(int frame);
+				// Forget predecoded instructions for a
+				// physical frame whose contents changed.
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     // FIXME : addr should be unsigned int as well as value in WriteMem    
@@ -172,6 +218,21 @@ class Machine {
 				// code and data, while executing
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    Instruction *decodeCache;	// predecoded copy of each word of
+				// mainMemory, indexed by physical addr / 4
+    bool *decodeValid;		// true if the matching decodeCache
+				// entry reflects the word in mainMemory
+
+    XlateCacheEntry xlateCache[XlateCacheSize];
+				// recent translations of the current
+				// address space, indexed by vpn
+
+    int pendingTicks;		// instructions RunBlock has completed
+				// but not yet charged to the clock
+    bool trapped;		// set when an exception returns or a
+				// mapping or frame changes, so RunBlock
+				// knows to end the block
+
 
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
@@ -67,8 +67,35 @@ Machine::Run()
 
     DSTRM_EVENT_DATA(MACHINE, RUN, currentThread->Get_Id(), sizeof(int), &(stats->totalTicks), "print_int");
 
+    // Per-tick interrupt tracing needs a OneTick after every instruction
+    bool tracing = DebugIsEnabled((char *)DB_INTERRUPT);
+    bool batches = runTickless && !tracing;
+    bool blocks = runBasicBlocks && !tracing;
+
     interrupt->setStatus(UserMode);
     for (;;) {
+#ifdef REMOTE_USER_PROGRAM_DEBUGGING
+	if (!singleStep && breakpoints.IsEmpty()) {
+	    if (batches) {
+		RunBatch(instr);
+		continue;
+	    }
+	    if (blocks) {
+		RunBlock(instr);
+		continue;
+	    }
+	}
+#else
+	if (batches) {
+	    RunBatch(instr);
+	    continue;
+	}
+	if (blocks) {
+	    RunBlock(instr);
+	    continue;
+	}
+#endif
+
 #ifdef REMOTE_USER_PROGRAM_DEBUGGING
 	int addr;
 	bool trapFlag = singleStep;
@@ -89,6 +116,99 @@ Machine::Run()
 }
 
 
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Execute a straight-line run of user instructions starting at the
+//	current PC, the way Run would with OneInstruction/OneTick, but
+//	translating the fetch address once and calling OneTick only for
+//	the last instruction of the block.
+//
+//	The block ends at the first instruction that does not fall
+//	through to the next word (a taken branch ends the block after
+//	its delay slot), at any exception, when the kernel flushes a
+//	translation or rewrites a frame (the frame we are fetching from
+//	may have been paged out and reused, say by a copy-on-write store
+//	under memory pressure), at the end of the physical frame, or
+//	when Interrupt::TicksUntilDue says the next tick could make an
+//	interrupt due.  The ticks of the earlier instructions are
+//	charged without looking for interrupts -- none can be due -- and
+//	RaiseException charges them before the kernel runs, so the clock,
+//	stats->userTicks and the interrupt timing are the same as with
+//	the one-instruction-at-a-time loop.
+//----------------------------------------------------------------------
+void
+Machine::RunBlock(Instruction *instr)
+{
+    int start = registers[PCReg];
+    int budget = interrupt->TicksUntilDue();
+    int count = 0;
+    unsigned int word, end;
+
+    if (!FetchWord(start, &word)) {	// the fetch itself faulted
+	interrupt->OneTick();
+	return;
+    }
+
+    // The next virtual page can be in any frame, so stay in this one
+    end = (word / InstrsPerPage + 1) * InstrsPerPage;
+
+    for (;;) {
+	// A store earlier in the block may have overwritten this word
+	if (!decodeValid[word])
+	    DecodeWord(word);
+	*instr = decodeCache[word];
+
+	trapped = false;
+	ExecuteInstruction(instr);
+	count++;
+	word++;
+
+	if (trapped || count >= budget || word == end ||
+	    registers[PCReg] != start + 4 * count)
+	    break;
+	pendingTicks++;
+    }
+
+    if (pendingTicks > 0) {
+	interrupt->ChargeUserTicks(pendingTicks);
+	pendingTicks = 0;
+    }
+    interrupt->OneTick();
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBatch
+// 	The tickless counterpart of RunBlock: execute user instructions
+//	one after another, through branches and across pages, until the
+//	next interrupt deadline (timer, disk, console or a pending
+//	reschedule, per Interrupt::TicksUntilDue) or the first exception.
+//	Only the last instruction goes through OneTick; the ticks of the
+//	others are charged in one go, by RaiseException if an exception
+//	ends the batch.  Since no interrupt can come due inside the
+//	batch, the clock and the order in which handlers run are those
+//	of the one-instruction-at-a-time loop.
+//----------------------------------------------------------------------
+void
+Machine::RunBatch(Instruction *instr)
+{
+    int budget = interrupt->TicksUntilDue();
+
+    for (int count = 1; ; count++) {
+	trapped = false;
+	OneInstruction(instr);
+	if (trapped || count >= budget)
+	    break;
+	pendingTicks++;
+    }
+
+    if (pendingTicks > 0) {
+	interrupt->ChargeUserTicks(pendingTicks);
+	pendingTicks = 0;
+    }
+    interrupt->OneTick();
+}
+
+
 //----------------------------------------------------------------------
 // TypeToReg
 // 	Retrieve the register # referred to in an instruction. 
@@ -131,22 +251,35 @@ TypeToReg(RegType reg, Instruction *instr)
 //	store all data back to the machine registers and memory before
 //	leaving.  This allows the Nachos kernel to control our behavior
 //	by controlling the contents of memory, the translation table,
-//	and the register set.
+//	and the register set.  The one exception is the predecode cache
+//	(see FetchInstruction), which is keyed by physical address and
+//	invalidated whenever the underlying memory changes, so it never
+//	holds anything the kernel could observe.
 //----------------------------------------------------------------------
 
 void
 Machine::OneInstruction(Instruction *instr)
 {
-    unsigned int raw;
+    // Fetch instruction, predecoded if we have seen this word before
+    if (!machine->FetchInstruction(registers[PCReg], instr))
+	return;			// exception occurred
+    ExecuteInstruction(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteInstruction
+// 	Execute an instruction that has already been fetched and decoded
+//	from registers[PCReg], then advance the program counters.  Shared
+//	by OneInstruction and RunBlock.
+//----------------------------------------------------------------------
+
+void
+Machine::ExecuteInstruction(Instruction *instr)
+{
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
                                 // in the future
-    
 
-    // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
-	return;			// exception occurred
-    instr->Decode(raw);
     if (DebugIsEnabled( (char *)DB_MACHINE ))
       {
 	struct OpString *str = &opStrings[instr->opCode];
@@ -20,16 +20,32 @@
 //----------------------------------------------------------------------
 
 Statistics::Statistics()
-  : interPageFaultTimes( Histogram::HistoN1, Histogram::HistoWidth1, Histogram::HistoMin1 )
+  : interPageFaultTimes( Histogram::HistoN1, Histogram::HistoWidth1, Histogram::HistoMin1 ),
+    cpuShares( 11, 10, 0 ),
+    diskReadLatency( 40, RotationTime, 0 ),
+    diskWriteLatency( 40, RotationTime, 0 )
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numContextSwitches = numVolContextSwitches = numInvolContextSwitches = 0;
+    numRegisterSaves = numRegisterRestores = 0;
+    numRegisterCopiesSkipped = numPageTableReloadsSkipped = 0;
+    numThreadsRecycled = numStacksRecycled = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskRunRequests = numDiskRunSectors = 0;
+    numDiskCacheHits = numDiskCacheMisses = 0;
+    numDiskWritesAbsorbed = numSectorsFlushed = numFsyncs = 0;
+    numDiskRequestsQueued = numDiskSeekTracks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPageIns = numPageOuts = 0;
+    numPagesCleaned = numClustersWritten = 0;
+    numWriteBehindHits = numWriteBehindMisses = 0;
+    numPrefetchHits = numPrefetchMisses = 0;
+    numZeroPageMaps = numPagesMerged = 0;
+    numImageCacheHits = numSharedTextMaps = 0;
     numPacketsSent = numPacketsRecvd = 0;
 
     ticksAtLastPageFault = 0;
+    tickets = runnableTicks = 0;
 }
 
 //----------------------------------------------------------------------
@@ -44,11 +60,73 @@ Statistics::Print()
     printf("Ticks: total %u, idle %u, system %u, user %u\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
     printf("Context switches: %u\n", numContextSwitches);
+    if (numRegisterRestores + numRegisterCopiesSkipped > 0) {
+	printf("User context: register saves %u, restores %u, "
+	       "copies skipped %u, page table reloads skipped %u\n",
+	       numRegisterSaves, numRegisterRestores,
+	       numRegisterCopiesSkipped, numPageTableReloadsSkipped);
+    }
+    if (numThreadsRecycled + numStacksRecycled > 0) {
+	printf("Thread pool: control blocks reused %u, stacks reused %u\n",
+	       numThreadsRecycled, numStacksRecycled);
+    }
     printf("Disk I/O: reads %u, writes %u\n", numDiskReads, numDiskWrites);
+    if (numDiskRunRequests > 0) {
+	printf("Disk runs: multi-sector requests %u, sectors %u "
+	       "(%.1f per request)\n", numDiskRunRequests, numDiskRunSectors,
+	       (double) numDiskRunSectors / numDiskRunRequests);
+    }
+    if (numDiskCacheHits + numDiskCacheMisses > 0) {
+	printf("Buffer cache: hits %u, misses %u (%.1f%% hit)\n",
+	       numDiskCacheHits, numDiskCacheMisses,
+	       100.0 * numDiskCacheHits /
+	       (numDiskCacheHits + numDiskCacheMisses));
+    }
+    if (numDiskRequestsQueued > 0) {
+	bool overflowed = false;
+	size_t reads = diskReadLatency.Count(overflowed);
+	size_t writes = diskWriteLatency.Count(overflowed);
+	HistoDatumT readTicks = diskReadLatency.Sum(overflowed);
+	HistoDatumT writeTicks = diskWriteLatency.Sum(overflowed);
+
+	printf("Disk queue: requests queued %u, seek tracks %u (%.2f per "
+	       "request), mean latency read %.0f, write %.0f\n",
+	       numDiskRequestsQueued, numDiskSeekTracks,
+	       (reads + writes == 0) ? 0.0 :
+	       (double) numDiskSeekTracks / (reads + writes),
+	       (reads == 0) ? 0.0 : (double) readTicks / reads,
+	       (writes == 0) ? 0.0 : (double) writeTicks / writes);
+    }
+    if (numDiskWritesAbsorbed + numSectorsFlushed > 0) {
+	printf("Write-back: writes absorbed %u, sectors flushed %u, "
+	       "fsyncs %u\n", numDiskWritesAbsorbed, numSectorsFlushed,
+	       numFsyncs);
+    }
     printf("Console I/O: reads %u, writes %u\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %u, pageins %u, pageouts %u\n", numPageFaults,
 	   numPageIns, numPageOuts);
+    if (numPagesCleaned > 0) {
+	unsigned int dirtyVictims = numWriteBehindHits + numWriteBehindMisses;
+
+	printf("Page cleaner: pages cleaned %u, clusters written %u, "
+	       "write-behind hits %u of %u (%.1f%%)\n",
+	       numPagesCleaned, numClustersWritten, numWriteBehindHits,
+	       dirtyVictims, (dirtyVictims == 0) ? 0.0 :
+	       100.0 * numWriteBehindHits / dirtyVictims);
+    }
+    if (numPrefetchHits + numPrefetchMisses > 0) {
+	printf("Fault-around: prefetch hits %u, misses %u\n",
+	       numPrefetchHits, numPrefetchMisses);
+    }
+    if (numZeroPageMaps + numPagesMerged > 0) {
+	printf("Page sharing: zero-page maps %u, frames merged %u\n",
+	       numZeroPageMaps, numPagesMerged);
+    }
+    if (numImageCacheHits + numSharedTextMaps > 0) {
+	printf("Image cache: header hits %u, shared text maps %u\n",
+	       numImageCacheHits, numSharedTextMaps);
+    }
     printf("Network I/O: packets received %u, sent %u\n", numPacketsRecvd, 
 	numPacketsSent);
     DSTRM_EVENT(STATS, PAGE_FAULTS, numPageFaults);
@@ -73,5 +151,25 @@ Statistics::ShortPrint(int pid)
     printf("  \t%u reads, %u writes, %u faults, %u pageins, %u pageouts\n",
 		numConsoleCharsRead, numConsoleCharsWritten, 
 		numPageFaults, numPageIns, numPageOuts);
+    if (numPrefetchHits + numPrefetchMisses > 0) {
+	printf("  \t%u prefetch hits, %u prefetch misses\n",
+		numPrefetchHits, numPrefetchMisses);
+    }
+    if (tickets > 0) {
+	bool overflowed = false;
+	size_t slices = cpuShares.Count(overflowed);
+	HistoDatumT sum = cpuShares.Sum(overflowed);
+	HistoDatumT low = 0, high = 0;
+
+	(void) cpuShares.Minimum(low);
+	(void) cpuShares.Maximum(high);
+	printf("  \t%u tickets, ran %u of %u runnable ticks (%.1f%%)\n",
+		tickets, userTicks + systemTicks, runnableTicks,
+		(runnableTicks == 0) ? 0.0 :
+		100.0 * (userTicks + systemTicks) / runnableTicks);
+	if (slices > 0 && !overflowed)
+	    printf("  \tshare per slice: min %d%%, mean %d%%, max %d%%\n",
+		    low, (int) (sum / (HistoDatumT) slices), high);
+    }
 }
 
@@ -32,11 +32,31 @@ class Statistics {
 				// user instructions executed)
 
     unsigned int numContextSwitches;     // number of context switches
+    unsigned int numRegisterSaves;       // user register sets copied out
+    unsigned int numRegisterRestores;    // user register sets copied in
+    unsigned int numRegisterCopiesSkipped; // switches that found the
+                                         // thread's registers still live
+    unsigned int numPageTableReloadsSkipped; // switches that found the
+                                         // page table still loaded
+    unsigned int numThreadsRecycled;     // TCBs taken from the pool
+    unsigned int numStacksRecycled;      // stacks taken from the pool
     unsigned int numVolContextSwitches;  // number of voluntary context switches
     unsigned int numInvolContextSwitches;// number of invol. context switches
 
     unsigned int numDiskReads;		 // number of disk read requests
     unsigned int numDiskWrites;		 // number of disk write requests
+    unsigned int numDiskRunRequests;	 // requests for more than one sector
+    unsigned int numDiskRunSectors;	 // ... and the sectors they moved
+    unsigned int numDiskCacheHits;	 // sector reads served by the
+                                         // buffer cache
+    unsigned int numDiskCacheMisses;	 // ... that had to go to the disk
+    unsigned int numDiskWritesAbsorbed;	 // writes to an already dirty
+                                         // sector in the write-back cache
+    unsigned int numSectorsFlushed;	 // dirty sectors written back
+    unsigned int numFsyncs;		 // Fsync system calls
+    unsigned int numDiskRequestsQueued;	 // requests that found the disk
+                                         // busy and waited in the queue
+    unsigned int numDiskSeekTracks;	 // tracks the head moved across
     unsigned int numConsoleCharsRead;	 // number of characters read from the 
                                          // keyboard
     unsigned int numConsoleCharsWritten; // number of characters written to 
@@ -45,6 +65,20 @@ class Statistics {
                                          // faults
     unsigned int numPageIns;             // number of virtual memory pageins
     unsigned int numPageOuts;            // number of virtual memory pageouts
+    unsigned int numPagesCleaned;        // dirty pages written to swap
+                                         // ahead of time by the page cleaner
+    unsigned int numClustersWritten;     // swap writes the cleaner issued
+    unsigned int numWriteBehindHits;     // dirty victims already cleaned
+    unsigned int numWriteBehindMisses;   // dirty victims written on eviction
+    unsigned int numPrefetchHits;        // fault-around pages later used
+    unsigned int numPrefetchMisses;      // fault-around pages evicted unused
+    unsigned int numZeroPageMaps;        // zero-fill faults served by
+                                         // mapping the shared zero frame
+    unsigned int numPagesMerged;         // frames freed by deduplication
+    unsigned int numImageCacheHits;      // execs that found their headers
+                                         // in the image cache
+    unsigned int numSharedTextMaps;      // text faults served by mapping
+                                         // another instance's frame
     unsigned int numPacketsSent;	 // number of packets sent over the 
                                          // network
     unsigned int numPacketsRecvd;	 // number of packets received over 
@@ -58,6 +92,16 @@ class Statistics {
 
     Histogram interPageFaultTimes; // histogram of times elapsed between page faults
     unsigned int ticksAtLastPageFault;
+
+    // Stride scheduling (per process only)
+    unsigned int tickets;	   // tickets held when last runnable
+    unsigned int runnableTicks;	   // time spent ready or running
+    Histogram cpuShares;	   // percent of the CPU received over each
+				   // interval between two charges
+
+    // Disk requests, from when they were made until they completed
+    Histogram diskReadLatency;
+    Histogram diskWriteLatency;
 };
 
 // Constants used to reflect the relative time an operation would
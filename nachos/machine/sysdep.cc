@@ -36,6 +36,7 @@ extern "C" {
 #include <sys/time.h>
 #include <sys/socket.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <sys/un.h>
 #include <sys/mman.h>
 #ifdef HOST_i386
@@ -259,6 +260,23 @@ Tell(int fd)
 #endif
 }
 
+//----------------------------------------------------------------------
+// FileStamp
+// 	Report which host file an open file is, and when it was last
+//	modified, so that callers can tell if it has changed since.
+//----------------------------------------------------------------------
+
+void
+FileStamp(int fd, long *identity, long *version)
+{
+    struct stat info;
+    int retVal = fstat(fd, &info);
+
+    ASSERT(retVal >= 0);
+    *identity = (long) info.st_ino;
+    *version = (long) info.st_mtime;
+}
+
 
 //----------------------------------------------------------------------
 // Close
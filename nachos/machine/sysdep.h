@@ -29,6 +29,7 @@ extern int ReadPartial(int fd, void *buffer, size_t nBytes);
 extern void WriteFile(int fd, void *buffer, size_t nBytes);
 extern void Lseek(int fd, int offset, int whence);
 extern int Tell(int fd);
+extern void FileStamp(int fd, long *identity, long *version);
 extern void Close(int fd);
 extern bool Unlink(char *name);
 
@@ -64,10 +64,15 @@ Machine::ReadMem(int addr, int size, void *value)
 	BREAKPOINT(breakAddr);
 #endif
 
-    exception = Translate(addr, &physicalAddress, size, false);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return false;
+    char *hostAddr = CachedTranslate(addr, size, false);
+    if (hostAddr != NULL) {
+	physicalAddress = hostAddr - mainMemory;
+    } else {
+	exception = Translate(addr, &physicalAddress, size, false);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return false;
+	}
     }
     switch (size) {
       case 1:
@@ -94,6 +99,95 @@ Machine::ReadMem(int addr, int size, void *value)
     return true;
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+//      Read the instruction at virtual address "addr" and return it in
+//	decoded form.  Each word of physical memory has a slot in
+//	decodeCache, so an instruction executed repeatedly (a loop body,
+//	for instance) is only run through Instruction::Decode once, until
+//	its frame is written or reused.
+//
+//   	Returns false if the translation step from virtual to physical memory
+//   	failed.
+//
+//	"addr" -- the virtual address of the instruction (the PC)
+//	"instr" -- the place to put the decoded instruction
+//----------------------------------------------------------------------
+
+bool
+Machine::FetchInstruction(int addr, Instruction *instr)
+{
+    unsigned int word;
+
+    if (!FetchWord(addr, &word))
+	return false;
+
+    // Hand back a copy, so that nothing the instruction does to memory
+    // can change the instruction while it is executing
+    *instr = decodeCache[word];
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Machine::FetchWord
+//      Translate the virtual address of an instruction, raising any
+//	exception the fetch causes, and make sure the decodeCache slot
+//	for the physical word holds its current decoding.
+//
+//   	Returns false if the translation step from virtual to physical memory
+//   	failed.
+//
+//	"addr" -- the virtual address of the instruction
+//	"word" -- the place to put the index of its decodeCache slot
+//----------------------------------------------------------------------
+
+bool
+Machine::FetchWord(int addr, unsigned int *word)
+{
+    ExceptionType exception;
+    int physicalAddress;
+
+    DEBUG( (char *)DB_ADDRESS , (char *)"Fetching instruction at VA 0x%x\n", addr);
+
+#ifdef REMOTE_USER_PROGRAM_DEBUGGING
+    int breakAddr;
+    if (breakpoints.queryBreakpoint(addr, 4, ReadWp, breakAddr))
+	BREAKPOINT(breakAddr);
+#endif
+
+    char *hostAddr = CachedTranslate(addr, 4, false);
+    if (hostAddr != NULL) {
+	physicalAddress = hostAddr - mainMemory;
+    } else {
+	exception = Translate(addr, &physicalAddress, 4, false);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return false;
+	}
+    }
+
+    *word = (unsigned) physicalAddress / 4;
+    if (!decodeValid[*word])
+	DecodeWord(*word);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodeWord
+//      Decode one word of physical memory into its decodeCache slot.
+//
+//	"word" -- the physical address of the word, divided by 4
+//----------------------------------------------------------------------
+
+void
+Machine::DecodeWord(unsigned int word)
+{
+    unsigned int raw = ((unsigned int *) mainMemory)[word];
+
+    decodeCache[word].Decode(WordToHost(raw));
+    decodeValid[word] = true;
+}
+
 //----------------------------------------------------------------------
 // Machine::WriteMem
 //      Write "size" (1, 2, or 4) bytes of the contents of "value" into
@@ -121,11 +215,20 @@ Machine::WriteMem(int addr, int size, int value)
 	BREAKPOINT(breakAddr);
 #endif
 
-    exception = Translate(addr, &physicalAddress, size, true);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return false;
+    char *hostAddr = CachedTranslate(addr, size, true);
+    if (hostAddr != NULL) {
+	physicalAddress = hostAddr - mainMemory;
+    } else {
+	exception = Translate(addr, &physicalAddress, size, true);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return false;
+	}
     }
+
+    // The word being written may have been predecoded as an instruction
+    decodeValid[(unsigned) physicalAddress / 4] = false;
+
     switch (size) {
       case 1:
 	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -228,6 +331,13 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	}
     }
 
+    // The first reference to a page fault-around brought in is the
+    // fault it saved
+    if (entry->prefetched) {
+      entry->prefetched = false;
+      currentThread->space->NotePrefetchHit ();
+    }
+
     // VIRTUAL_MEMORY
     if (entry->cow && writing) {
       DEBUG( (char *)DB_ADDRESS , (char *)"Copy-on-write hit at %d\n", virtAddr);
@@ -253,9 +363,86 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     // FIXME: This should not be an assert; it should raise some exception
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG( (char *)DB_ADDRESS , (char *)"phys addr = 0x%x\n", *physAddr);
+
+    // Remember the translation, so the next access to this page can
+    // skip all of the above
+    if (tlb == NULL) {
+	XlateCacheEntry *slot = &xlateCache[vpn % XlateCacheSize];
+
+	slot->vpn = vpn;
+	slot->entry = entry;
+	slot->frame = &mainMemory[pageFrame * PageSize];
+	slot->writable = !entry->cow;
+    }
     return NoException;
 }
 
+//----------------------------------------------------------------------
+// Machine::CachedTranslate
+// 	Translate a virtual address using only the translation cache.
+//	On a hit, set the use, history and dirty bits of the page table
+//	entry exactly as Translate would, and return the host address of
+//	the byte in mainMemory.  Return NULL if Translate has to be called:
+//	the page is not cached, the access is misaligned (Translate raises
+//	the error), or it is a store to a copy-on-write page.
+//
+//	The cache is only correct as long as the kernel flushes it
+//	whenever a cached mapping changes: FlushTranslation when a page
+//	is paged out or copied on write, FlushTranslations when the page
+//	table is switched or copy-on-write is turned on for a fork.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"size" -- the amount of memory being read or written
+// 	"writing" -- true for a store
+//----------------------------------------------------------------------
+
+char *
+Machine::CachedTranslate(int virtAddr, int size, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    XlateCacheEntry *slot = &xlateCache[vpn % XlateCacheSize];
+
+    if ((slot->vpn != vpn) || (virtAddr & (size - 1)) ||
+	(writing && !slot->writable))
+	return NULL;
+
+    slot->entry->use = true;
+    slot->entry->history |= 0x80; // 678 set MSB to 1
+    if (writing)
+	slot->entry->dirty = true;
+    return slot->frame + (unsigned) virtAddr % PageSize;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushTranslation
+// 	Drop the cached translation of virtual page "vpn", if any.  A
+//	block RunBlock is in the middle of may have been fetched through
+//	that mapping, so it ends after the current instruction.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTranslation(unsigned int vpn)
+{
+    XlateCacheEntry *slot = &xlateCache[vpn % XlateCacheSize];
+
+    if (slot->vpn == vpn)
+	slot->vpn = NoXlate;
+    trapped = true;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushTranslations
+// 	Drop every cached translation, and end the current block.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTranslations()
+{
+    for (int i = 0; i < XlateCacheSize; i++)
+	xlateCache[i].vpn = NoXlate;
+    trapped = true;
+}
+
 
 // FIXME: Wrap these in ASSIGNMENT markers
 
@@ -56,6 +56,8 @@ class TranslationEntry {
 
     bool cow;           // copy-on-write; do we need to copy the page
 			// before we write to it
+    bool prefetched;    // brought in by fault-around, and not referenced
+			// since
 
 
     void clearSC ();
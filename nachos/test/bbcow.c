@@ -0,0 +1,76 @@
+/* bbcow.c
+ *	Regression test for the -bb basic-block engine: copy-on-write
+ *	stores under memory pressure.
+ *
+ *	The array is zero-fill and larger than physical memory, so with
+ *	-zshare every first store to one of its pages copies the shared
+ *	zero frame, and the copy has to evict some other frame -- often
+ *	the one holding the code being run.  After a fork, both
+ *	processes store to pages the other still shares, which copies
+ *	them again.  If the engine went on running a block out of a
+ *	frame that had been reused, the sums would come out wrong (or
+ *	the program would fault).
+ *
+ *	Run it as "nachos -bb -zshare -x bbcow".
+ */
+
+#include "syscall.h"
+#include "stdlib.h"
+
+#define Pages		256	/* twice physical memory */
+#define WordsPerPage	32	/* PageSize / sizeof (int) */
+
+int array[Pages * WordsPerPage];
+
+/* Store one word in every page */
+void
+fill (int base)
+{
+  int page;
+
+  for (page = 0; page < Pages; page++)
+    array[page * WordsPerPage + (page % WordsPerPage)] = base + page;
+}
+
+/* Check what fill (base) left */
+int
+check (int base)
+{
+  int page, sum = 0, expected = 0;
+
+  for (page = 0; page < Pages; page++) {
+    sum += array[page * WordsPerPage + (page % WordsPerPage)];
+    expected += base + page;
+  }
+  return sum == expected;
+}
+
+void
+report (char *what, int ok)
+{
+  Write (ConsoleOutput, what, strlen (what));
+  if (ok)
+    Write (ConsoleOutput, ": ok\n", 5);
+  else
+    Write (ConsoleOutput, ": FAILED\n", 9);
+}
+
+int
+main ()
+{
+  int status;
+
+  fill (1);
+  report ("stores to zero-fill pages", check (1));
+
+  if (Fork () == 0) {
+    fill (1000);
+    report ("child stores to copy-on-write pages", check (1000));
+    Exit (0);
+  }
+  fill (2000);
+  report ("parent stores to copy-on-write pages", check (2000));
+  Wait (&status);
+  Halt ();
+  /* not reached */
+}
@@ -0,0 +1,64 @@
+/* fsync.c
+ *	Test program for the Fsync system call.
+ *
+ *	Writes to a new file and checks that Fsync on it succeeds, that
+ *	Fsync on the console succeeds, and that a descriptor that was
+ *	never opened, is out of range, or has been closed is refused
+ *	with EBADF.
+ */
+
+#include "syscall.h"
+#include "stdlib.h"
+
+extern int errno;
+
+int failures = 0;
+
+void
+check (char *what, int ok)
+{
+  Write (ConsoleOutput, what, strlen (what));
+  if (ok) {
+    Write (ConsoleOutput, ": ok\n", 5);
+  } else {
+    Write (ConsoleOutput, ": FAILED\n", 9);
+    failures++;
+  }
+}
+
+int
+main ()
+{
+  OpenFileId fd;
+  int result;
+
+  Create ("fsync.out");
+  fd = Open ("fsync.out");
+  check ("open a new file", fd >= 0);
+
+  Write (fd, "written before fsync\n", 21);
+  result = Fsync (fd);
+  check ("fsync after a write returns 0", result == 0);
+
+  result = Fsync (ConsoleOutput);
+  check ("fsync on the console returns 0", result == 0);
+
+  result = Fsync (100);
+  check ("fsync on an unopened fd returns EBADF",
+	 result == -1 && errno == 9);
+
+  result = Fsync (-1);
+  check ("fsync on a negative fd returns EBADF",
+	 result == -1 && errno == 9);
+
+  Close (fd);
+  result = Fsync (fd);
+  check ("fsync on a closed fd returns EBADF",
+	 result == -1 && errno == 9);
+
+  Unlink ("fsync.out");
+  if (failures == 0)
+    Write (ConsoleOutput, "fsync: all passed\n", 18);
+  Halt ();
+  /* not reached */
+}
@@ -0,0 +1,92 @@
+/* futex.c
+ *	Test program for the FutexWait, FutexWake and FutexAdd system
+ *	calls.
+ *
+ *	Checks the calls that return at once (a stale value, a bad futex
+ *	number, a wake with nobody asleep, a FutexAdd that would go below
+ *	zero), then uses two futexes as semaphores between processes: a
+ *	forked child sleeps taking "Go", the parent wakes it, and the
+ *	parent sleeps taking "Done" until the child releases it.
+ */
+
+#include "syscall.h"
+#include "stdlib.h"
+
+extern int errno;
+
+#define Word	0		/* futex for the single-process checks */
+#define Go	1		/* parent -> child */
+#define Done	2		/* child -> parent */
+
+int failures = 0;
+
+void
+check (char *what, int ok)
+{
+  Write (ConsoleOutput, what, strlen (what));
+  if (ok) {
+    Write (ConsoleOutput, ": ok\n", 5);
+  } else {
+    Write (ConsoleOutput, ": FAILED\n", 9);
+    failures++;
+  }
+}
+
+void
+down (int futex)
+{
+  while (FutexAdd (futex, -1) < 0)
+    FutexWait (futex, 0);
+}
+
+int
+up (int futex)
+{
+  FutexAdd (futex, 1);
+  return FutexWake (futex, 1);
+}
+
+int
+main ()
+{
+  int i, result, status;
+
+  result = FutexWait (Word, 1);
+  check ("wait on a changed word returns EAGAIN",
+	 result == -1 && errno == 11);
+
+  result = FutexWait (NumFutexes, 0);
+  check ("wait on a bad futex number returns EINVAL",
+	 result == -1 && errno == 22);
+
+  result = FutexWake (Word, 1);
+  check ("wake with no sleepers wakes nobody", result == 0);
+
+  result = FutexAdd (Word, -1);
+  check ("add below zero returns EAGAIN",
+	 result == -1 && errno == 11 && FutexAdd (Word, 0) == 0);
+
+  result = FutexAdd (Word, 2);
+  check ("add returns the new value",
+	 result == 2 && FutexAdd (Word, -2) == 0);
+
+  if (Fork () == 0) {
+    down (Go);			/* sleeps until the parent's up */
+    up (Done);
+    Exit (0);
+  }
+  for (i = 0; i < 10; i++)	/* let the child get to sleep */
+    Yield ();
+
+  result = up (Go);
+  check ("wake reaches a sleeper in another process", result == 1);
+
+  down (Done);
+  check ("woken process can wake us back", FutexAdd (Done, 0) == 0);
+
+  Wait (&status);
+  if (failures == 0)
+    Write (ConsoleOutput, "futex: all passed\n", 18);
+  Halt ();
+  /* not reached */
+}
@@ -8,24 +8,43 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debug categories> -rs <random seed #>
+// Usage: nachos -sweep <spec file> [-j <jobs>]
+//    or nachos -d <debug categories> -rs <random seed #>
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
-//		-f -cp <unix file> <nachos file>
+//		-f -cp <unix file> <nachos file> -bc <sectors>
+//		-wb <ticks> -dsched <fifo|clook|scan>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
-//              -S <swap file>
-//              -q <size in ticks>
+//              -S <swap file> -bb -tickless -pclean
+//              -fa <pages> -faa -zshare -dedup -xcache
+//              -prp <dumb|fifo|lru|secondchance|clock>
+//              -q <size in ticks> -sched <priority|mlfq|cfs|stride>
 //              -R <double value in the range (0.0, 1.0]>
 //              -H <histogram specification>
 //              -i <inertial quanta>
+//              -tpool <threads>
 //              -z
 //              -cwss
 //
+//    -sweep runs each line of the spec file as the arguments of a
+//       separate nachos, up to <jobs> (default: host CPUs) at a time,
+//       each with its own swap file, and merges their statistics
+//       (see sweep.cc).  It must be the first argument.
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //    -q is the number of ticks between scheduler interrupts (~ quantum)
+//    -sched selects the scheduling policy.  priority (the default)
+//       keeps one ready list sorted by priority.  mlfq keeps a FIFO
+//       queue per level; a thread at level L runs for 2^L quanta
+//       before it is demoted, and goes back to the top level when it
+//       wakes up from blocking.  cfs runs the thread with the least
+//       virtual runtime (CPU ticks scaled down by a weight that grows
+//       as the Nice priority value falls).  stride gives each thread
+//       tickets by its Nice priority value and runs the one with the
+//       lowest pass; each thread's achieved CPU share is printed with
+//       -printstats
 //    -R is the factor by which a thread discards some of its
 //       dynamic priority advantage as it leaves the CPU
 //    -H 'n1,width1,min1;n2,width2,min2' histogram specification
@@ -35,6 +54,12 @@
 //       1 is for the inactive histogram and 1 is for the active
 //    -i is the number of quanta for which a thread that just obtained
 //       the CPU gets to run before being susceptible to pre-emption
+//    -tpool keeps up to this many freed thread control blocks (and,
+//       without pthreads, stacks) for reuse by later threads
+//    -prp selects the page replacement policy.  clock is global: it
+//       picks victims among all processes' frames, unless the faulting
+//       process is over its working set, when only its own frames are
+//       candidates
 //    -cwss enables the immediate contraction of the working set if
 //       the working set size decreases (frames are paged-out until the
 //       process no longer has too many frames)
@@ -42,6 +67,23 @@
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
+//    -bb runs user programs a basic block at a time (same ticks)
+//    -tickless runs user programs in batches that end only at the next
+//       interrupt deadline or exception (same ticks); overrides -bb
+//    -fa reads up to this many following pages of the same file run
+//       into free frames on a page fault
+//    -faa makes the -fa window adaptive: halved when a read-ahead page
+//       is evicted unused, grown by one when one is used
+//    -zshare maps untouched zero-fill pages copy-on-write to a single
+//       frame of zeroes
+//    -dedup merges identical clean frames at the same virtual page of
+//       different processes when memory is full
+//    -xcache keeps the parsed headers of every executable run (checked
+//       against the file's length, modification time and raw headers
+//       at each Exec), and lets a text fault map the frame of another
+//       running instance of the same executable instead of reading it
+//    -pclean starts a kernel thread that writes dirty, cold pages to
+//       swap in clusters, so that eviction mostly finds clean frames
 //    -c tests the console
 //
 //  FILESYS
@@ -52,6 +94,18 @@
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system 
 //    -t tests the performance of the Nachos file system
+//    -bc keeps this many recently used disk sectors in a buffer cache,
+//       replaced least recently used first; reads that hit cost no
+//       disk time (writes still go through to the disk, unless -wb)
+//    -wb makes the -bc cache write-back: a write only dirties the
+//       cached sector, and a flusher thread writes all dirty sectors
+//       out, in sector order, this many ticks after the first of them
+//       was dirtied (and on Fsync, eviction, and halt)
+//    -dsched orders the requests queued while the disk is busy: fifo
+//       (the default) by arrival, clook by sector upwards from the head
+//       and then round from the lowest, scan by nearest in the head's
+//       direction of travel, turning at the last.  Per-request latency
+//       histograms are written to disk{Read,Write}Latency.histo
 //
 //  NETWORK
 //    -n sets the network reliability
@@ -80,6 +134,7 @@ extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
+extern int RunSweep(int argc, char **argv);
 
 //----------------------------------------------------------------------
 // main
@@ -100,6 +155,10 @@ main(int argc, char **argv)
 {
     int argCount;			// the number of arguments 
 					// for a particular command
+
+    if (argc > 2 && !strcmp(argv[1], "-sweep"))	// a batch of runs, each
+	return RunSweep(argc, argv);		// its own nachos process
+
     DSUI_BEGIN(&argc, &argv);
 //    DEBUG( DB_THREAD , "Entering main");
     (void) Initialize(argc, argv);
@@ -11,8 +11,11 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	By default the ready threads are kept on one list sorted by
+//	priority.  With -sched mlfq they are kept instead in a
+//	multi-level feedback queue (see Scheduler::SliceExpired), and
+//	with -sched cfs or -sched stride in a heap ordered by virtual
+//	runtime or by pass.
 //
 // Copyright (c) 1993-1994 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -24,6 +27,7 @@
 #include "scheduler.h"
 #include "system.h"
 #include "nachos_dsui.h"
+#include <strings.h>
 
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
@@ -34,6 +38,14 @@ Scheduler::Scheduler (size_t quantum_in)
   threadid = 1;
   readyList.setComparator (ThreadOrder);
   quantum = quantum_in;
+  mlfqReady = 0;
+  mlfqSinceBoost = 0;
+  heapRoot = NULL;
+  heapSeq = 0;
+  minVruntime = 0;
+  globalPass = 0;
+  globalTickets = 0;
+  runNext = NULL;
 }
 
 
@@ -77,11 +89,38 @@ Scheduler::ReadyToRun (Thread *thread)
 	interrupt->setNeedResched();
       }
 
+    // A thread waking up from I/O (or any other wait) goes back to
+    // the top MLFQ level, so interactive threads are dispatched ahead
+    // of the CPU-bound ones that have sunk to the lower levels.
+    if (schedPolicy == MLFQ && thread->getStatus() == BLOCKED) {
+      thread->schedLevel = 0;
+      thread->quantaUsed = 0;
+    }
+
+    // The running thread is charged for its slice; anything else gets
+    // a virtual runtime near the rest of the ready threads.
+    if (schedPolicy == CFS) {
+      if (thread == currentThread)
+	CfsCharge(thread);
+      else
+	CfsPlace(thread);
+    } else if (schedPolicy == STRIDE) {
+      if (thread == currentThread)
+	StrideCharge(thread);
+      else
+	StrideJoin(thread);
+    }
+
     // The thread is now in the ready state...
     thread->setStatus(READY);
 
     // ... so add it to the ready list
-    readyList.Insert(thread);
+    if (schedPolicy == MLFQ)
+      MlfqEnqueue(thread);
+    else if (schedPolicy == CFS || schedPolicy == STRIDE)
+      HeapInsert(thread);
+    else
+      readyList.Insert(thread);
 }
 
 // debugging function
@@ -140,11 +179,407 @@ Scheduler::FindNextToRun ()
   // Choose the priority-wise best ready thread, the "candidate" for
   // replacing the current thread
   //
-  nextThread = static_cast<Thread *>(readyList.Remove());
+  if (schedPolicy == MLFQ)
+    nextThread = MlfqDequeue();
+  else if ((schedPolicy == CFS || schedPolicy == STRIDE) && runNext != NULL) {
+    // Switch_To picked this one; it keeps its key, and so is charged
+    // for the time it runs ahead of its turn like any other
+    nextThread = runNext;
+    HeapRemove(nextThread);
+  } else if (schedPolicy == CFS) {
+    nextThread = HeapRemoveMin();
+    if (nextThread != NULL && nextThread->schedKey > minVruntime)
+      minVruntime = nextThread->schedKey;
+  } else if (schedPolicy == STRIDE)
+    nextThread = HeapRemoveMin();
+  else
+    nextThread = static_cast<Thread *>(readyList.Remove());
 
   return nextThread;
 }
 
+//----------------------------------------------------------------------
+// Scheduler::SliceExpired
+// 	Called by the scheduler timer interrupt handler while a thread
+//	is running.  Returns true if that thread should be pre-empted.
+//
+//	With the priority list every quantum ends the slice.  With the
+//	multi-level feedback queue a thread at level L may run for 2^L
+//	quanta; when it has used them it drops a level (CPU-bound threads
+//	sink, and get longer but rarer slices).  It is also pre-empted
+//	early if a thread is ready at a better level.  Every
+//	MlfqBoostPeriod quanta all threads go back to level 0, so that
+//	nothing starves at the bottom.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::SliceExpired()
+{
+  bool expired;
+
+  if (schedPolicy != MLFQ)
+    return true;
+
+  expired = ++currentThread->quantaUsed >= (1U << currentThread->schedLevel);
+  if (expired) {
+    if (currentThread->schedLevel < MlfqLevels - 1)
+      currentThread->schedLevel++;
+    currentThread->quantaUsed = 0;
+    DEBUG((char *) DB_THREAD, (char *)"Thread %s demoted to level %d\n",
+	  currentThread->GetName(), currentThread->schedLevel);
+  }
+
+  if (++mlfqSinceBoost >= MlfqBoostPeriod) {
+    mlfqSinceBoost = 0;
+    MlfqBoost();
+  }
+
+  return expired ||
+    (mlfqReady & ((1U << currentThread->schedLevel) - 1)) != 0;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::MlfqEnqueue, Scheduler::MlfqDequeue, Scheduler::MlfqRemove
+// 	Maintain the per-level FIFOs and the bitmap of non-empty levels.
+//	The best non-empty level is the lowest set bit of the bitmap, so
+//	picking the next thread does not depend on the number of levels
+//	or of ready threads.
+//----------------------------------------------------------------------
+
+void
+Scheduler::MlfqEnqueue(Thread *thread)
+{
+  int level = thread->schedLevel;
+
+  ASSERT(level >= 0 && level < MlfqLevels);
+  mlfqQueue[level].Append(thread);
+  mlfqReady |= 1U << level;
+}
+
+Thread *
+Scheduler::MlfqDequeue()
+{
+  Thread *thread;
+  int level;
+
+  if (mlfqReady == 0)
+    return NULL;
+  level = ffs(mlfqReady) - 1;
+  thread = static_cast<Thread *>(mlfqQueue[level].Remove());
+  if (mlfqQueue[level].IsEmpty())
+    mlfqReady &= ~(1U << level);
+  return thread;
+}
+
+bool
+Scheduler::MlfqRemove(Thread *thread)
+{
+  int level = thread->schedLevel;
+
+  if (mlfqQueue[level].Remove(thread) == NULL)
+    return false;
+  if (mlfqQueue[level].IsEmpty())
+    mlfqReady &= ~(1U << level);
+  return true;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::MlfqBoost
+// 	Move every ready thread, and the running one, back to level 0.
+//----------------------------------------------------------------------
+
+void
+Scheduler::MlfqBoost()
+{
+  Thread *thread;
+
+  for (int level = 1; level < MlfqLevels; level++) {
+    while (!mlfqQueue[level].IsEmpty()) {
+      thread = static_cast<Thread *>(mlfqQueue[level].Remove());
+      thread->schedLevel = 0;
+      thread->quantaUsed = 0;
+      MlfqEnqueue(thread);
+    }
+  }
+  mlfqReady &= 1U;
+  currentThread->schedLevel = 0;
+  currentThread->quantaUsed = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadRunTicks
+// 	The CPU time a thread has used so far.  Only differences of this
+//	are used, so without per-process statistics the system clock
+//	(which only advances while the thread runs) does as well.
+//----------------------------------------------------------------------
+
+static unsigned int
+ThreadRunTicks(Thread *thread)
+{
+#ifdef USER_PROGRAM
+  return thread->procStats->userTicks + thread->procStats->systemTicks;
+#else
+  (void) thread;
+  return stats->totalTicks;
+#endif
+}
+
+// Weight of each Nice value from -20 to 19 (priority 0 to 39); each
+// step is about 1.25 times the next, so that one Nice step changes a
+// thread's CPU share by about 10%.  Priority 20, the default, weighs
+// NiceZeroWeight.  The stride scheduler uses the weights as tickets.
+static const int NiceZeroWeight = 1024;
+static const int niceWeights[40] = {
+  88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+  9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,
+  1024,  820,   655,   526,   423,   335,   272,   215,   172,   137,
+  110,   87,    70,    56,    45,    36,    29,    23,    18,    15
+};
+
+static int
+NiceWeight(Thread *thread)
+{
+  int priority = thread->Get_Priority();
+
+  return niceWeights[(priority > 39) ? 39 : priority];
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CfsCharge
+// 	Add the CPU time "thread" has used since it was last charged to
+//	its virtual runtime, scaled by NiceZeroWeight / weight, so that
+//	threads with a lower Nice priority value age more slowly and get
+//	proportionally more of the CPU.
+//----------------------------------------------------------------------
+
+void
+Scheduler::CfsCharge(Thread *thread)
+{
+  unsigned int now = ThreadRunTicks(thread);
+
+  thread->schedKey += (long long) (now - thread->runStart) * NiceZeroWeight
+    / NiceWeight(thread);
+  thread->runStart = now;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CfsPlace
+// 	Set the virtual runtime of a thread joining the ready heap other
+//	than from the CPU.  A new thread starts at minVruntime.  A thread
+//	waking up keeps its own value unless that is more than a quantum
+//	behind, so a long sleep earns a short head start rather than a
+//	monopoly of the CPU.
+//----------------------------------------------------------------------
+
+void
+Scheduler::CfsPlace(Thread *thread)
+{
+  long long floor = minVruntime;
+
+  if (thread->getStatus() != JUST_CREATED)
+    floor -= quantum;
+  if (thread->schedKey < floor)
+    thread->schedKey = floor;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StrideJoin
+// 	"thread" becomes runnable: add its tickets to the total, and put
+//	its pass the same distance from globalPass as when it left, so
+//	blocking neither earns nor loses it CPU time.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StrideJoin(Thread *thread)
+{
+  thread->tickets = NiceWeight(thread);
+  globalTickets += thread->tickets;
+  thread->schedKey = globalPass + thread->passRemain;
+  thread->runnableSince = stats->totalTicks;
+#ifdef USER_PROGRAM
+  thread->procStats->tickets = thread->tickets;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StrideLeave
+// 	"thread" blocked or finished: remember how far its pass is from
+//	globalPass, and take its tickets out of the total.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StrideLeave(Thread *thread)
+{
+  thread->passRemain = thread->schedKey - globalPass;
+  globalTickets -= thread->tickets;
+  thread->tickets = 0;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StrideCharge
+// 	Advance the pass of "thread", and globalPass, for the ticks it has
+//	run since it was last charged, and record the share of the CPU it
+//	received while runnable over that interval.  A Nice call takes
+//	effect here, by changing the thread's tickets.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StrideCharge(Thread *thread)
+{
+  unsigned int now = ThreadRunTicks(thread);
+  unsigned int used = now - thread->runStart;
+  int tickets;
+
+  if (thread->tickets == 0)		// e.g. the main thread, which
+    StrideJoin(thread);			// was never made ready
+  thread->runStart = now;
+  thread->schedKey += used * (StrideOne / thread->tickets);
+  globalPass += used * (StrideOne / globalTickets);
+
+#ifdef USER_PROGRAM
+  unsigned int window = stats->totalTicks - thread->runnableSince;
+
+  if (window > 0) {
+    thread->procStats->runnableTicks += window;
+    thread->procStats->cpuShares.RecordDatum((int) (100LL * used / window));
+  }
+#endif
+  thread->runnableSince = stats->totalTicks;
+
+  tickets = NiceWeight(thread);
+  if (tickets != thread->tickets) {
+    globalTickets += tickets - thread->tickets;
+    thread->tickets = tickets;
+#ifdef USER_PROGRAM
+    thread->procStats->tickets = tickets;
+#endif
+  }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Heap*
+// 	A pairing heap of ready threads, linked through the heap* fields
+//	of Thread and ordered by (schedKey, schedSeq).  Insert and meld
+//	are constant time; removing the minimum, or any given thread,
+//	takes amortized logarithmic time.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::HeapLess(Thread *a, Thread *b) const
+{
+  if (a->schedKey != b->schedKey)
+    return a->schedKey < b->schedKey;
+  return (int) (a->schedSeq - b->schedSeq) < 0;
+}
+
+// Meld two heaps whose roots have no siblings; return the new root.
+Thread *
+Scheduler::HeapMeld(Thread *a, Thread *b)
+{
+  Thread *t;
+
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+  if (HeapLess(b, a)) {
+    t = a;
+    a = b;
+    b = t;
+  }
+  b->heapPrev = a;
+  b->heapNext = a->heapChild;
+  if (a->heapChild != NULL)
+    a->heapChild->heapPrev = b;
+  a->heapChild = b;
+  return a;
+}
+
+// Meld a list of sibling heaps: in pairs left to right, then the
+// results right to left.
+Thread *
+Scheduler::HeapMergePairs(Thread *first)
+{
+  Thread *pairs = NULL, *root = NULL, *a, *b;
+
+  while (first != NULL) {
+    a = first;
+    b = a->heapNext;
+    first = (b != NULL) ? b->heapNext : NULL;
+    a->heapNext = a->heapPrev = NULL;
+    if (b != NULL)
+      b->heapNext = b->heapPrev = NULL;
+    a = HeapMeld(a, b);
+    a->heapNext = pairs;
+    pairs = a;
+  }
+  while (pairs != NULL) {
+    a = pairs;
+    pairs = a->heapNext;
+    a->heapNext = NULL;
+    root = HeapMeld(root, a);
+  }
+  return root;
+}
+
+void
+Scheduler::HeapInsert(Thread *thread)
+{
+  thread->schedSeq = heapSeq++;
+  thread->heapChild = thread->heapNext = thread->heapPrev = NULL;
+  heapRoot = HeapMeld(heapRoot, thread);
+}
+
+Thread *
+Scheduler::HeapRemoveMin()
+{
+  Thread *min = heapRoot;
+
+  if (min != NULL) {
+    heapRoot = HeapMergePairs(min->heapChild);
+    min->heapChild = NULL;
+    if (min == runNext)
+      runNext = NULL;
+  }
+  return min;
+}
+
+// Remove a particular thread; false if it was not in the heap.
+bool
+Scheduler::HeapRemove(Thread *thread)
+{
+  if (thread == heapRoot) {
+    (void) HeapRemoveMin();
+    return true;
+  }
+  if (thread->heapPrev == NULL)
+    return false;
+  if (thread == runNext)
+    runNext = NULL;
+
+  if (thread->heapPrev->heapChild == thread)
+    thread->heapPrev->heapChild = thread->heapNext;
+  else
+    thread->heapPrev->heapNext = thread->heapNext;
+  if (thread->heapNext != NULL)
+    thread->heapNext->heapPrev = thread->heapPrev;
+  thread->heapNext = thread->heapPrev = NULL;
+
+  heapRoot = HeapMeld(heapRoot, HeapMergePairs(thread->heapChild));
+  thread->heapChild = NULL;
+  return true;
+}
+
+// Put every thread in the heap on "list", in no particular order.
+static void
+HeapCollect(Thread *thread, List *list)
+{
+  for (; thread != NULL; thread = thread->heapNext) {
+    list->Append(thread);
+    HeapCollect(thread->heapChild, list);
+  }
+}
+
 
 //----------------------------------------------------------------------
 // Scheduler::Run
@@ -171,14 +606,21 @@ Scheduler::Run (Thread *nextThread)
 
 #ifdef USER_PROGRAM			// ignore until running user programs 
     if (currentThread->space != NULL) {	// if this thread is a user program,
-        currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveState();
-    }
+	currentThread->space->SaveState(); // its CPU registers stay in the
+    }					// machine until someone needs it
 #endif
 
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
+    if (schedPolicy == CFS)		    // charge the CPU time it used
+	CfsCharge(oldThread);
+    else if (schedPolicy == STRIDE && oldThread->getStatus() != READY) {
+	StrideCharge(oldThread);	    // and, if it is not coming
+	StrideLeave(oldThread);		    // back, its tickets
+    }
+    nextThread->runStart = ThreadRunTicks(nextThread);
+
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
 
@@ -227,8 +669,7 @@ Scheduler::Run (Thread *nextThread)
 
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
-        currentThread->RestoreUserState();     // to restore, do it.
-	currentThread->space->RestoreState();
+        currentThread->RestoreUserContext();	// to restore, do it.
     }
 #endif
 }
@@ -247,7 +688,7 @@ Scheduler::PrintReadyList()
 	// Set the tag
 	DebugInit((char *)"show_readylist");
 
-	debugShowReadyList( readyList );
+	ShowReadyList();
 
 	// Only want to print list when called, not every iteration or
     	// subsequent calls to debugShowReadyList that might be made
@@ -256,11 +697,36 @@ Scheduler::PrintReadyList()
 
     }
     else {	
-    	debugShowReadyList( readyList );
+    	ShowReadyList();
     }
    
 }
 
+//----------------------------------------------------------------------
+// Scheduler::ShowReadyList
+// 	Hand the ready threads of the current policy, best first, to
+//	debugShowReadyList.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ShowReadyList()
+{
+    if (schedPolicy == MLFQ) {
+	for (int level = 0; level < MlfqLevels; level++)
+	    if (mlfqReady & (1U << level))
+		debugShowReadyList( mlfqQueue[level] );
+    }
+    else if (schedPolicy == CFS || schedPolicy == STRIDE) {
+	List heapOrder;
+
+	HeapCollect(heapRoot, &heapOrder);
+	debugShowReadyList( heapOrder );
+    }
+    else {
+    	debugShowReadyList( readyList );
+    }
+}
+
 
 //----------------------------------------------------------------------
 // Scheduler::addToList
@@ -329,6 +795,10 @@ Scheduler::removeFromList (Thread* thread)
 Thread *
 Scheduler::GetThis (Thread* thread)
 {
+  if (schedPolicy == MLFQ)
+    return MlfqRemove(thread) ? thread : NULL;
+  if (schedPolicy == CFS || schedPolicy == STRIDE)
+    return HeapRemove(thread) ? thread : NULL;
   return static_cast<Thread *>(readyList.Remove (thread));
 }
 #endif
@@ -357,12 +827,21 @@ void Scheduler::Switch_To( Thread * newthread ) {
   // Remove the thread from the ready list.
   // So we don't have it on there twice.
   //
-  readyList.Delete (newthread);  
+  if (schedPolicy == MLFQ) {
+    MlfqRemove(newthread);
+    newthread->schedLevel = 0;
+    mlfqQueue[0].Prepend(newthread);
+    mlfqReady |= 1U;
+  } else if (schedPolicy == CFS || schedPolicy == STRIDE) {
+    runNext = newthread;
+  } else {
+    readyList.Delete (newthread);  
 
-  //
-  // Add it to the front of the readylist.
-  //
-  readyList.Prepend (newthread);
+    //
+    // Add it to the front of the readylist.
+    //
+    readyList.Prepend (newthread);
+  }
   
   currentThread->Yield();
 }
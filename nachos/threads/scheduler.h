@@ -45,6 +45,9 @@ public:
   void Switch_To( Thread * newthread );	// Switch to execute newthread.
 
   size_t Quantum() const;
+  bool SliceExpired();			// Called on each scheduler timer
+					// interrupt; true if the running
+					// thread should be pre-empted
 
 
 private:
@@ -54,6 +57,59 @@ private:
   SortedList readyList;			// queue of threads that are ready to
 					// run, but are not running
 
+  // Multi-level feedback queue (-sched mlfq).  Level L is a FIFO of
+  // ready threads whose slice is 2^L quanta; bit L of mlfqReady is
+  // set when that FIFO is non-empty.
+  static const int MlfqLevels = 8;
+  static const unsigned int MlfqBoostPeriod = 256; // quanta between
+					// moving everything to level 0
+  List mlfqQueue[MlfqLevels];
+  unsigned int mlfqReady;
+  unsigned int mlfqSinceBoost;
+
+  void MlfqEnqueue(Thread *thread);	// add to the tail of its level
+  Thread *MlfqDequeue();		// take the head of the best level
+  bool MlfqRemove(Thread *thread);	// take a particular thread off
+  void MlfqBoost();			// move every thread to level 0
+
+  // Completely fair scheduling (-sched cfs).  Ready threads are kept
+  // in a pairing heap ordered by Thread::schedKey, their virtual
+  // runtime.  minVruntime trails the smallest key handed out, and is
+  // where new and waking threads are placed.
+  Thread *heapRoot;
+  unsigned int heapSeq;
+  long long minVruntime;
+
+  void CfsCharge(Thread *thread);	// add the CPU used since the
+					// last charge to the vruntime
+  void CfsPlace(Thread *thread);	// set the key of a thread that
+					// is not coming off the CPU
+
+  // Stride scheduling (-sched stride).  The same heap is ordered by
+  // pass; a thread's pass advances by StrideOne / tickets per tick it
+  // runs, and globalPass by StrideOne / globalTickets, the total held
+  // by runnable threads.
+  static const long long StrideOne = 1 << 20;
+  long long globalPass;
+  int globalTickets;
+
+  void StrideJoin(Thread *thread);	// thread becomes runnable
+  void StrideLeave(Thread *thread);	// thread blocks or finishes
+  void StrideCharge(Thread *thread);	// advance pass for ticks run
+
+  Thread *runNext;			// ready thread Switch_To asked for,
+					// taken ahead of the heap minimum
+
+  bool HeapLess(Thread *a, Thread *b) const;
+  Thread *HeapMeld(Thread *a, Thread *b);
+  Thread *HeapMergePairs(Thread *first);
+  void HeapInsert(Thread *thread);
+  Thread *HeapRemoveMin();
+  bool HeapRemove(Thread *thread);
+
+  void ShowReadyList();			// print the ready threads, for
+					// PrintReadyList
+
   int threadid;
 };
 
@@ -0,0 +1,194 @@
+// sweep.cc
+//	Run a batch of independent Nachos simulations in parallel on the
+//	host, for parameter sweeps.
+//
+//	    nachos -sweep <spec file> [-j <jobs>]
+//
+//	Each non-blank line of the spec file that does not start with '#'
+//	holds the arguments of one run, for example
+//
+//	    -prp lru -delta 4 -x ../test/access1 -H 76,10,0;20,10,0
+//
+//	Every run is a fresh nachos process (so it goes through main and
+//	Initialize with nothing left over from the others), with its own
+//	swap file and DSUI output, and its stdout and stderr captured in
+//	sweep.<run>.out.  At most <jobs> runs, by default one per host
+//	CPU, are live at once.  When all have finished, the "Ticks:" and
+//	"Paging:" lines of every run are printed in spec order, and also
+//	written to sweep.results.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "utility.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define MaxSweepRuns	1024
+#define MaxSweepArgs	64
+#define MaxSweepLine	1024
+
+struct SweepRun {
+    char *args;			// the spec line
+    pid_t pid;			// while running
+    int status;			// as returned by waitpid
+};
+
+//----------------------------------------------------------------------
+// StartRun
+// 	Fork and exec one run of "program" with the arguments in
+//	"run->args", plus a private swap file and DSUI output.
+//----------------------------------------------------------------------
+
+static void
+StartRun(char *program, SweepRun *run, int which)
+{
+    char *argv[MaxSweepArgs + 8];
+    char swapName[32], outName[32];
+#ifdef CONFIG_DSUI
+    char dsuiName[32];
+#endif
+    char *line, *arg;
+    int argc = 0, fd;
+
+    sprintf(swapName, "swapfile.sweep.%d", which);
+#ifdef CONFIG_DSUI
+    sprintf(dsuiName, "sweep.%d.dsui.bin", which);
+#endif
+    sprintf(outName, "sweep.%d.out", which);
+
+    run->pid = fork();
+    ASSERT(run->pid >= 0);
+    if (run->pid > 0)
+	return;
+
+    // the child
+    fd = open(outName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT(fd >= 0);
+    dup2(fd, 1);
+    dup2(fd, 2);
+    close(fd);
+
+    argv[argc++] = program;
+    argv[argc++] = (char *) "-S";
+    argv[argc++] = swapName;
+#ifdef CONFIG_DSUI
+    argv[argc++] = (char *) "--dsui-output";
+    argv[argc++] = dsuiName;
+#endif
+    line = strdup(run->args);
+    for (arg = strtok(line, " \t"); arg != NULL && argc < MaxSweepArgs + 5;
+	 arg = strtok(NULL, " \t"))
+	argv[argc++] = arg;
+    argv[argc] = NULL;
+
+    execv(program, argv);
+    perror(program);
+    _exit(127);
+}
+
+//----------------------------------------------------------------------
+// PrintRun
+// 	Copy the summary lines of one finished run's output to "out".
+//----------------------------------------------------------------------
+
+static void
+PrintRun(FILE *out, SweepRun *run, int which)
+{
+    char outName[32], line[MaxSweepLine];
+    FILE *in;
+
+    fprintf(out, "[%d] %s", which, run->args);
+    if (!WIFEXITED(run->status) || WEXITSTATUS(run->status) != 0)
+	fprintf(out, "  (%s %d)", WIFEXITED(run->status) ? "exit" : "signal",
+		WIFEXITED(run->status) ? WEXITSTATUS(run->status) :
+		WTERMSIG(run->status));
+    fprintf(out, "\n");
+
+    sprintf(outName, "sweep.%d.out", which);
+    if ((in = fopen(outName, "r")) == NULL)
+	return;
+    while (fgets(line, sizeof(line), in) != NULL)
+	if (!strncmp(line, "Ticks:", 6) || !strncmp(line, "Paging:", 7))
+	    fprintf(out, "    %s", line);
+    fclose(in);
+}
+
+//----------------------------------------------------------------------
+// RunSweep
+// 	Parse "-sweep <spec file> [-j <jobs>]" from the command line,
+//	run every line of the spec, and merge the results.  Returns the
+//	number of runs that failed.
+//----------------------------------------------------------------------
+
+int
+RunSweep(int argc, char **argv)
+{
+    static SweepRun runs[MaxSweepRuns];
+    char line[MaxSweepLine], *start;
+    int numRuns = 0, next = 0, live = 0, failed = 0;
+    int jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    pid_t pid;
+    int status, i;
+    FILE *spec, *results;
+
+    ASSERT(argc > 2 && !strcmp(argv[1], "-sweep"));
+    if (argc > 4 && !strcmp(argv[3], "-j"))
+	jobs = atoi(argv[4]);
+    if (jobs < 1)
+	jobs = 1;
+
+    if ((spec = fopen(argv[2], "r")) == NULL) {
+	perror(argv[2]);
+	return 1;
+    }
+    while (fgets(line, sizeof(line), spec) != NULL) {
+	line[strcspn(line, "\r\n")] = '\0';
+	for (start = line; *start == ' ' || *start == '\t'; start++)
+	    ;
+	if (*start == '\0' || *start == '#')
+	    continue;
+	ASSERT(numRuns < MaxSweepRuns);
+	runs[numRuns++].args = strdup(start);
+    }
+    fclose(spec);
+
+    printf("Sweep: %d runs, %d at a time\n", numRuns, jobs);
+    fflush(stdout);
+    while (next < numRuns || live > 0) {
+	if (next < numRuns && live < jobs) {
+	    StartRun(argv[0], &runs[next], next);
+	    next++;
+	    live++;
+	    continue;
+	}
+	pid = wait(&status);
+	ASSERT(pid > 0);
+	for (i = 0; i < next; i++)
+	    if (runs[i].pid == pid) {
+		runs[i].status = status;
+		runs[i].pid = 0;
+		live--;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		    failed++;
+	    }
+    }
+
+    results = fopen("sweep.results", "w");
+    for (i = 0; i < numRuns; i++) {
+	PrintRun(stdout, &runs[i], i);
+	if (results != NULL)
+	    PrintRun(results, &runs[i], i);
+    }
+    if (results != NULL)
+	fclose(results);
+    return failed;
+}
@@ -28,6 +28,7 @@ Statistics *stats;			// performance metrics
 Timer *schedTimer;			// the hardware timer device,
 					// for invoking context switches
 char* mainProgramName;			// -x parameter nachos was launched with
+SchedPolicies schedPolicy = PRIORITY;	// how the ready threads are ordered
 
 
 
@@ -42,6 +43,9 @@ FileSystem  *fileSystem;
 
 #ifdef FILESYS
 SynchDisk   *synchDisk;
+int diskCacheSectors = 0;	// size of the sector buffer cache
+int diskFlushDelay = 0;		// write-back delay, 0 for write-through
+DiskSchedPolicies diskSchedPolicy = DISK_FIFO;	// order of queued requests
 #endif
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
@@ -56,6 +60,14 @@ SwapManager *swap;
 Console *console;
 bool wasYieldOnReturn = false;
 bool printProcStats = false;
+bool runBasicBlocks = false;
+bool runTickless = false;
+bool runPageCleaner = false;
+int faultAroundPages = 0;
+bool faultAroundAdaptive = false;
+bool shareZeroPages = false;
+bool dedupPages = false;
+bool execImageCache = false;
 int wsDeltaSize = 1;
 PageReplPolicies pageReplPolicy = DUMB;
 
@@ -120,13 +132,21 @@ SchedTimerInterruptHandler(size_t dummy)
   if (interrupt->getStatus() != IdleMode)
     {
       // refresh the current thread's working set size, if its time
+#ifdef USER_PROGRAM
+      // (kernel threads such as the page cleaner have no working set)
+      if ( (currentThread->space != NULL) &&
+	   currentThread->incrWssRefreshCounter() )
+	  currentThread->refreshWss();
+#else
       if ( currentThread->incrWssRefreshCounter() )
 	  currentThread->refreshWss();
+#endif
 
       // possibly pre-empt the thread when the interrupt handler
       // returns (when the handler finishes and the thread is about to
-      // resume processing)
-      interrupt->YieldOnReturn();
+      // resume processing), if it has used up its time slice
+      if (scheduler->SliceExpired())
+	interrupt->YieldOnReturn();
     }
 }
 
@@ -186,6 +206,23 @@ Initialize(int argc, char **argv)
 	    schedTimerTicks = atoi(*(argv + 1));
 	    argCount = 2;
 	  }
+	else if (!strcmp(*argv, "-sched"))
+	  { // --> choose the scheduling policy
+	    ASSERT(argc > 1);
+	    if (!strcmp (*(argv+1), "priority")) {
+	      schedPolicy = PRIORITY;
+	    } else if (!strcmp (*(argv+1), "mlfq")) {
+	      schedPolicy = MLFQ;
+	    } else if (!strcmp (*(argv+1), "cfs")) {
+	      schedPolicy = CFS;
+	    } else if (!strcmp (*(argv+1), "stride")) {
+	      schedPolicy = STRIDE;
+	    } else {
+	      printf ("Unknown scheduling policy: %s\n", *(argv+1));
+	      ASSERT (false);
+	    }
+	    argCount = 2;
+	  }
 	else if (!strcmp(*argv, "-H"))
 	  { // --> set the histogram bounds
 	    ASSERT(argc > 1);
@@ -208,6 +245,12 @@ Initialize(int argc, char **argv)
 	    ASSERT(argc > 1);
 	    argCount = 2;
 	  }
+	else if (!strcmp(*argv, "-tpool"))
+	  { // --> set the most thread control blocks and stacks kept
+	    ASSERT(argc > 1);
+	    Thread::poolLimit = atoi(*(argv + 1));
+	    argCount = 2;
+	  }
 	else if (!strcmp(*argv, "-cw"))
 	  { // --> set the number of inertial quanta
 	    ASSERT(argc > 1);
@@ -247,6 +290,25 @@ Initialize(int argc, char **argv)
             noSwitch = true;
         } else if (!strcmp(*argv, "-printstats")) {
             printProcStats = true;
+        } else if (!strcmp(*argv, "-bb")) {
+            runBasicBlocks = true;
+        } else if (!strcmp(*argv, "-tickless")) {
+            runTickless = true;
+        } else if (!strcmp(*argv, "-pclean")) {
+            runPageCleaner = true;
+        } else if (!strcmp(*argv, "-fa")) {
+            ASSERT(argc > 1);
+            faultAroundPages = atoi (*(argv + 1));
+            ASSERT(faultAroundPages >= 0);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-faa")) {
+            faultAroundAdaptive = true;
+        } else if (!strcmp(*argv, "-zshare")) {
+            shareZeroPages = true;
+        } else if (!strcmp(*argv, "-dedup")) {
+            dedupPages = true;
+        } else if (!strcmp(*argv, "-xcache")) {
+            execImageCache = true;
         } else if (!strcmp(*argv, "-delta")) {
             ASSERT(argc > 1);
             wsDeltaSize = atoi (*(argv + 1));
@@ -261,6 +323,8 @@ Initialize(int argc, char **argv)
                 pageReplPolicy = SECONDCHANCE;
             } else if (!strcmp (*(argv+1), "dumb")) {
                 pageReplPolicy = DUMB;
+            } else if (!strcmp (*(argv+1), "clock")) {
+                pageReplPolicy = GLOBALCLOCK;
             } else {
                 printf ("Unknown page replacement policy: %s\n", *(argv+1));
                 ASSERT (false);
@@ -274,6 +338,30 @@ Initialize(int argc, char **argv)
 	if (!strcmp(*argv, "-f"))
 	    format = true;
 #endif
+#ifdef FILESYS
+	if (!strcmp(*argv, "-bc")) {
+	    ASSERT(argc > 1);
+	    diskCacheSectors = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-wb")) {
+	    ASSERT(argc > 1);
+	    diskFlushDelay = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dsched")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "fifo")) {
+		diskSchedPolicy = DISK_FIFO;
+	    } else if (!strcmp(*(argv + 1), "clook")) {
+		diskSchedPolicy = CLOOK;
+	    } else if (!strcmp(*(argv + 1), "scan")) {
+		diskSchedPolicy = SCAN;
+	    } else {
+		printf("Unknown disk scheduling policy: %s\n", *(argv + 1));
+		ASSERT(false);
+	    }
+	    argCount = 2;
+	}
+#endif
 #ifdef NETWORK
 	if (!strcmp(*argv, "-l")) {
 	    ASSERT(argc > 1);
@@ -318,7 +406,7 @@ Initialize(int argc, char **argv)
 #endif
 
 #ifdef FILESYS
-    synchDisk = new SynchDisk("DISK");
+    synchDisk = new SynchDisk("DISK", diskCacheSectors, diskFlushDelay);
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -339,6 +427,8 @@ Initialize(int argc, char **argv)
     consoleReadAvail = new KernelSemaphore((char *)"console read avail", 0);
     consoleWriteDone = new KernelSemaphore((char *)"console write done", 0);
     console = new Console(NULL, NULL, ConsoleReadAvail, ConsoleWriteDone, 0);
+    if (runPageCleaner)
+      memory->StartCleaner();
 #endif
 }
 
@@ -371,6 +461,10 @@ Cleanup()
 
 #ifdef FILESYS
     delete synchDisk;
+    if (stats->numDiskRequestsQueued > 0) {
+	stats->diskReadLatency.Write("diskReadLatency.histo");
+	stats->diskWriteLatency.Write("diskWriteLatency.histo");
+    }
 #endif
     
     delete schedTimer;
@@ -402,6 +496,9 @@ Cleanup()
 	  case SECONDCHANCE:
 	    prpName = (char *)"SC";
 	    break;
+	  case GLOBALCLOCK:
+	    prpName = (char *)"CLOCK";
+	    break;
 	  }
 
 	sprintf( fname , "interPageFaultTimes-%s-%s-%u.histo"
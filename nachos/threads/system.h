@@ -29,7 +29,9 @@ class Interrupt;
 class MemoryManager;
 class SwapManager;
 
-enum PageReplPolicies {DUMB, FIFO, LRU, SECONDCHANCE};
+enum PageReplPolicies {DUMB, FIFO, LRU, SECONDCHANCE, GLOBALCLOCK};
+enum SchedPolicies {PRIORITY, MLFQ, CFS, STRIDE};
+enum DiskSchedPolicies {DISK_FIFO, CLOOK, SCAN};
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -45,9 +47,24 @@ extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
 extern bool wasYieldOnReturn;			// involuntary context switch
 extern bool printProcStats;			// print process statistics
+extern bool runBasicBlocks;			// use the basic-block engine
+extern bool runTickless;			// run user code in batches up
+						// to the next interrupt
+extern bool runPageCleaner;			// write dirty pages behind
+extern int faultAroundPages;			// most pages read ahead on
+						// a fault (0 = off)
+extern bool faultAroundAdaptive;		// shrink the window when
+						// read-ahead is wasted
+extern bool shareZeroPages;			// map zero-fill pages to one
+						// shared frame until written
+extern bool dedupPages;				// merge identical clean frames
+						// when memory is full
+extern bool execImageCache;			// cache exec headers and share
+						// text between instances
 extern int wsDeltaSize;				// Delta for working set
 						// calculations
 extern PageReplPolicies pageReplPolicy;		// Page-replacement policy
+extern SchedPolicies schedPolicy;		// CPU scheduling policy
 extern char* mainProgramName;			// -x parameter nachos was launched with
 
 #ifdef USER_PROGRAM
@@ -70,6 +87,9 @@ extern FileSystem  *fileSystem;
 #ifdef FILESYS
 #include "synchdisk.h"
 extern SynchDisk   *synchDisk;
+extern int diskCacheSectors;			// sector buffer cache size
+extern int diskFlushDelay;			// write-back delay in ticks
+extern DiskSchedPolicies diskSchedPolicy;	// disk request order
 #endif
 
 #ifdef NETWORK
@@ -34,6 +34,14 @@ double Thread::dpRetentionFactor = 0.0;
 
 bool Thread::wssContractionEnabled = false;
 
+int Thread::poolLimit = 0;
+void *Thread::freeThreads = NULL;
+int Thread::numFreeThreads = 0;
+#ifndef USE_PTHREAD
+unsigned int *Thread::freeStacks = NULL;
+int Thread::numFreeStacks = 0;
+#endif
+
 
 #ifdef USE_PTHREAD
 struct ForkArgs {
@@ -246,6 +254,7 @@ void Thread::refreshWss()
         newHistory = space->get_page_ptr(page)->history >> 1;   //bitwise l2r shift
         space->get_page_ptr(page)->history = newHistory;        //set new history
     }
+    space->RefileHistory();
 }
 
 //----------------------------------------------------------------------
@@ -271,6 +280,15 @@ Thread::Thread()
     setStatus(JUST_CREATED);
     Priority = 20;
     wssRefreshCounter = 0;
+    schedLevel = 0;
+    quantaUsed = 0;
+    schedKey = 0;
+    tickets = 0;
+    passRemain = 0;
+    runnableSince = 0;
+    schedSeq = 0;
+    runStart = 0;
+    heapChild = heapNext = heapPrev = NULL;
 
     thread_exit_status = false;
     
@@ -344,18 +362,60 @@ Thread::~Thread()
 	delete FDTable [i]; 
       }
     }
+    if (liveUserState == this)		// nobody to save them for
+      liveUserState = NULL;
     delete space;
     delete ChildExited;
 #endif
 
 #ifndef USE_PTHREAD
-    if (stack != NULL)
+    if (stack != NULL && numFreeStacks < poolLimit) {
+	*(unsigned int **) stack = freeStacks;	// keep it, guard pages
+	freeStacks = stack;			// and all, for the next
+	numFreeStacks++;			// thread
+    } else if (stack != NULL)
 	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
 #endif
 
     scheduler->removeFromList( this );
 }
 
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+// 	Allocate a thread control block from the pool if it has one, and
+//	put freed ones back in the pool until it holds poolLimit.  Fork
+//	and exit heavy programs then reuse the same few blocks instead
+//	of going through the heap for every process.
+//----------------------------------------------------------------------
+
+void *
+Thread::operator new(size_t size)
+{
+    void *tcb = freeThreads;
+
+    ASSERT(size == sizeof(Thread));
+    if (tcb == NULL)
+	return ::operator new(size);
+    freeThreads = *(void **) tcb;
+    numFreeThreads--;
+    stats->numThreadsRecycled++;
+    return tcb;
+}
+
+void
+Thread::operator delete(void *tcb)
+{
+    if (tcb == NULL)
+	return;
+    if (numFreeThreads >= poolLimit) {
+	::operator delete(tcb);
+	return;
+    }
+    *(void **) tcb = freeThreads;
+    freeThreads = tcb;
+    numFreeThreads++;
+}
+
 #ifdef USE_PTHREAD
 void *ThreadRoot(void *arg_struct)
 {
@@ -375,9 +435,8 @@ void *ThreadRoot(void *arg_struct)
   // Now run the appropriate functions
   DEBUG( (char *)DB_THREAD , (char *)"Starting thread \"%s\"\n", currentThread->GetName());
 #ifdef USER_PROGRAM
-  currentThread->RestoreUserState();
   if (currentThread->space != NULL) {
-    currentThread->space->RestoreState();
+    currentThread->RestoreUserContext();
   }
 #endif
   interrupt->Enable();
@@ -710,9 +769,8 @@ static void InterruptEnable()
 {
   DEBUG( DB_THREAD , "Starting thread \"%s\"\n", currentThread->GetName());
 #ifdef USER_PROGRAM
-  currentThread->RestoreUserState();
   if (currentThread->space != NULL) {
-    currentThread->space->RestoreState();
+    currentThread->RestoreUserContext();
   }
 #endif
   interrupt->Enable();
@@ -743,7 +801,13 @@ void
 Thread::StackAllocate (VoidFunctionPtr func, size_t arg)
 {
 #ifndef USE_PTHREAD
-    stack = (unsigned int *) AllocBoundedArray(StackSize * sizeof(int));
+    if (freeStacks != NULL) {
+	stack = freeStacks;
+	freeStacks = *(unsigned int **) stack;
+	numFreeStacks--;
+	stats->numStacksRecycled++;
+    } else
+	stack = (unsigned int *) AllocBoundedArray(StackSize * sizeof(int));
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
@@ -826,6 +890,56 @@ Thread::RestoreUserState()
 }
 
 
+//----------------------------------------------------------------------
+// Thread::LoadUserState
+//	Make this thread's user registers the ones in the machine.
+//
+//	The registers are saved lazily: a context switch leaves them in
+//	the machine, and liveUserState records whose they are.  They are
+//	only copied out when another user thread needs the machine, so
+//	switching to a kernel-only thread and back, or back to the same
+//	thread, copies nothing.
+//----------------------------------------------------------------------
+
+Thread *Thread::liveUserState = NULL;
+
+void
+Thread::LoadUserState()
+{
+    if (liveUserState == this) {
+	stats->numRegisterCopiesSkipped++;
+	return;
+    }
+    if (liveUserState != NULL) {
+	liveUserState->SaveUserState();
+	stats->numRegisterSaves++;
+    }
+    RestoreUserState();
+    stats->numRegisterRestores++;
+    liveUserState = this;
+}
+
+
+//----------------------------------------------------------------------
+// Thread::RestoreUserContext
+//	Get the machine ready to run this thread's user program: its
+//	registers, and its address space's page table, which is only
+//	reloaded (and the translation cache flushed) if the machine has
+//	been pointed at another table since.
+//----------------------------------------------------------------------
+
+void
+Thread::RestoreUserContext()
+{
+    LoadUserState();
+    if (space->IsLoaded()) {
+	stats->numPageTableReloadsSkipped++;
+    } else {
+	space->RestoreState();
+    }
+}
+
+
 //----------------------------------------------------------------------
 // Thread::find_next_available_fd
 //     Finds the next available file descriptor for this thread
@@ -151,6 +151,33 @@ public:
 
   static bool wssContractionEnabled;
 
+  // Thread control blocks (and, without pthreads, their stacks) are
+  // recycled through free pools instead of going back to the heap, up
+  // to poolLimit of each (the -tpool command line parameter).
+  static int poolLimit;
+  static void *operator new(size_t size);
+  static void operator delete(void *tcb);
+
+#ifdef USER_PROGRAM
+  static Thread *liveUserState;	// whose user registers are in the
+				// machine (see LoadUserState)
+#endif
+
+  // Per-thread state of the scheduling policies other than the
+  // default priority list (see Scheduler).
+  int schedLevel;		// MLFQ level, 0 is the highest
+  unsigned int quantaUsed;	// quanta run at the current level
+  long long schedKey;		// CFS virtual runtime or stride pass;
+				// the ready heap is ordered by it
+  int tickets;			// stride tickets while runnable, else 0
+  long long passRemain;		// pass left over when it last blocked
+  unsigned int runnableSince;	// when its runnable time was last added
+  unsigned int schedSeq;	// breaks ties in schedKey, FIFO
+  unsigned int runStart;	// CPU ticks used when last charged
+  Thread *heapChild;		// ready heap links (Scheduler::Heap*)
+  Thread *heapNext;
+  Thread *heapPrev;		// previous sibling, or parent if first
+
 
 
 #ifdef USER_PROGRAM 
@@ -225,6 +252,13 @@ public:
 
     int Priority;		// The static priority of a process (thread)
 
+    static void *freeThreads;	// pooled TCBs, linked through their
+    static int numFreeThreads;	// first word
+#ifndef USE_PTHREAD
+    static unsigned int *freeStacks; // pooled stacks, likewise
+    static int numFreeStacks;
+#endif
+
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
 // one for its state while executing user code, one for its state 
@@ -236,6 +270,10 @@ public:
   public:
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
+    void LoadUserState();		// make our registers the live ones,
+					// saving the previous owner's
+    void RestoreUserContext();		// LoadUserState, and load the page
+					// table unless it is still loaded
     void Write_Reg(int place, int value) { userRegisters[place] = value; }
     int Read_Reg(int place) { return userRegisters[place]; }
     AddrSpace *space;			// User code this thread is running.
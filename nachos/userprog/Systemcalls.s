@@ -173,6 +173,22 @@ $CloseDone:
 	j	$31
 	.end Close
 
+	.globl Fsync
+	.ent	Fsync
+Fsync:
+	addiu $2,$0,SC_Fsync
+	syscall
+	bgez	$2,$FsyncPos
+	subu	$3,$0,$2
+	sw	$3,errno
+	li	$2,-1
+	j	$FsyncDone
+$FsyncPos:
+	sw	$0,errno
+$FsyncDone:
+	j	$31
+	.end Fsync
+
 	.globl Fork
 	.ent	Fork
 Fork:
@@ -254,6 +270,57 @@ $NiceDone:
         .end Nice
 
 
+	.globl FutexWait
+	.ent	FutexWait
+FutexWait:
+	addiu $2,$0,SC_FutexWait
+	syscall
+	bgez	$2,$FutexWaitPos
+	subu	$3,$0,$2
+	sw	$3,errno
+	li	$2,-1
+	j	$FutexWaitDone
+$FutexWaitPos:
+	sw	$0,errno
+$FutexWaitDone:
+	j	$31
+	.end FutexWait
+
+
+	.globl FutexWake
+	.ent	FutexWake
+FutexWake:
+	addiu $2,$0,SC_FutexWake
+	syscall
+	bgez	$2,$FutexWakePos
+	subu	$3,$0,$2
+	sw	$3,errno
+	li	$2,-1
+	j	$FutexWakeDone
+$FutexWakePos:
+	sw	$0,errno
+$FutexWakeDone:
+	j	$31
+	.end FutexWake
+
+
+	.globl FutexAdd
+	.ent	FutexAdd
+FutexAdd:
+	addiu $2,$0,SC_FutexAdd
+	syscall
+	bgez	$2,$FutexAddPos
+	subu	$3,$0,$2
+	sw	$3,errno
+	li	$2,-1
+	j	$FutexAddDone
+$FutexAddPos:
+	sw	$0,errno
+$FutexAddDone:
+	j	$31
+	.end FutexAdd
+
+
 	.globl NameThread
 	.ent	NameThread
 NameThread:
@@ -23,6 +23,13 @@
 #define SWAPSHORT(x) x = ShortToHost (x)
 #define SWAPWORD(x) x = WordToHost (x)
 
+// Executables that have been loaded with -xcache
+static ExecImage *execImages = NULL;
+
+// The space whose page table the machine was last pointed at by
+// RestoreState, or NULL if that table has since been replaced or freed.
+static AddrSpace *loadedSpace = NULL;
+
 //----------------------------------------------------------------------
 // SwapSection
 // 	Do little endian to big endian conversion on the bytes in a
@@ -241,6 +248,126 @@ ReadHeaders (OpenFile *executable, NachosHeader *nachosH)
   return nachosH->file_header.e_entry;
 }
 
+//----------------------------------------------------------------------
+// RawHeaders
+// 	Read the ELF header and section header table of an executable as
+//	they are on disk, at the places the parsed headers "nachosH" give.
+//	Returns a new array and sets "size" to its length.
+//----------------------------------------------------------------------
+static char *
+RawHeaders (OpenFile *executable, NachosHeader *nachosH, int *size)
+{
+  int tableSize = nachosH->file_header.e_shnum *
+    nachosH->file_header.e_shentsize;
+  char *bytes;
+
+  *size = sizeof (Elf32_Elf_header) + tableSize;
+  bytes = new char[*size];
+  memset (bytes, 0, *size);
+  executable->ReadAt (bytes, sizeof (Elf32_Elf_header), 0);
+  executable->ReadAt (bytes + sizeof (Elf32_Elf_header), tableSize,
+		      nachosH->file_header.e_shoff);
+  return bytes;
+}
+
+//----------------------------------------------------------------------
+// ImageMatches
+// 	True if an executable is still the file an image cache entry was
+//	parsed from: the same length and (with the stub file system) the
+//	same host file and modification time, and byte for byte the same
+//	ELF and section headers, so that spaces sharing the entry's text
+//	frames are running the same layout.
+//----------------------------------------------------------------------
+static bool
+ImageMatches (ExecImage *image, OpenFile *executable, int length,
+	      long identity, long version)
+{
+  char *bytes;
+  int size;
+  bool same;
+
+  if ((image->length != length) || (image->identity != identity) ||
+      (image->version != version))
+    return false;
+
+  bytes = RawHeaders (executable, &image->header, &size);
+  same = (size == image->rawSize) && !memcmp (bytes, image->raw, size);
+  delete [] bytes;
+  return same;
+}
+
+//----------------------------------------------------------------------
+// DeleteImage
+// 	Free an image cache entry that is off the list and has no users.
+//----------------------------------------------------------------------
+static void
+DeleteImage (ExecImage *image)
+{
+  ASSERT (image->users == NULL);
+  delete [] image->name;
+  delete [] image->raw;
+  delete image;
+}
+
+//----------------------------------------------------------------------
+// LookupImage
+// 	Find the image cache entry for an executable, parsing its headers
+//	into a new entry if it has not been loaded before (or has changed
+//	since).  A stale entry for the same name is dropped once no space
+//	is still running it; one that is still in use stays until
+//	LeaveImage sees its last user go.
+//----------------------------------------------------------------------
+static ExecImage *
+LookupImage (char *name, OpenFile *executable)
+{
+  int length = executable->Length ();
+  long identity = 0, version = 0;
+  ExecImage *image, **link;
+
+#ifdef FILESYS_STUB
+  FileStamp (executable->get_fd (), &identity, &version);
+#endif
+
+  for (link = &execImages; (image = *link) != NULL; )
+    {
+      if (strcmp (image->name, name))
+	{
+	  link = &image->next;
+	  continue;
+	}
+      if (ImageMatches (image, executable, length, identity, version))
+	{
+	  stats->numImageCacheHits++;
+	  image->stale = false;
+	  return image;
+	}
+      if (image->users == NULL)
+	{
+	  *link = image->next;
+	  DeleteImage (image);
+	}
+      else
+	{
+	  image->stale = true;
+	  link = &image->next;
+	}
+    }
+
+  image = new ExecImage;
+  image->name = new char[strlen (name) + 1];
+  strcpy (image->name, name);
+  image->length = length;
+  image->identity = identity;
+  image->version = version;
+  image->stale = false;
+  image->startAddress = ReadHeaders (executable, &image->header);
+  image->raw = RawHeaders (executable, &image->header, &image->rawSize);
+  image->users = NULL;
+  image->next = execImages;
+  execImages = image;
+  return image;
+}
+
 // --------------------------------------------------------------------------
 // AddrSpace::CopyPageTable (TranslationEntry *oldPT, TranslationEntry 
 //			       *newPT, int numpages)
@@ -271,6 +398,7 @@ void AddrSpace::CopyPageTable (TranslationEntry *oldPT, TranslationEntry
       newPT[i].offset = oldPT[i].offset;
       newPT[i].zero = oldPT[i].zero;
       newPT[i].cow = oldPT[i].cow;
+      newPT[i].prefetched = false;
       newPT[i].clearSC ();
       newPT[i].setTime (oldPT[i].getTime());
       newPT[i].clearRefHistory ();
@@ -292,8 +420,10 @@ void AddrSpace::CopyPageTable (TranslationEntry *oldPT, TranslationEntry
 // Arguments:
 //          executable           This is the new file to load into the
 //                               user address space.
+//          name                 Its file name, for the image cache; may
+//                               be NULL.
 // --------------------------------------------------------------------------
-int AddrSpace::ModifySpace(OpenFile *executable)
+int AddrSpace::ModifySpace(OpenFile *executable, char *name)
 {
   NachosHeader nachosH;
   TranslationEntry *oldPageTable = pageTable;
@@ -302,7 +432,17 @@ int AddrSpace::ModifySpace(OpenFile *executable)
   uint32_t max_address = 0U, section_size = 0U;
 
   // Get the file and section headers, and retrieve the start address
-  startAddress = ReadHeaders (executable, &nachosH);
+  LeaveImage ();
+  if (execImageCache && (name != NULL))
+    {
+      JoinImage (LookupImage (name, executable));
+      nachosH = image->header;
+      startAddress = image->startAddress;
+    }
+  else
+    {
+      startAddress = ReadHeaders (executable, &nachosH);
+    }
 
   // How big is the address space? VIRTUAL_MEMORY
   // Find the section with the largest starting address, add on its size, and
@@ -341,6 +481,10 @@ int AddrSpace::ModifySpace(OpenFile *executable)
     }
   delete [] oldPageTable;
 
+  // The extent was sized for the old image; the new one reserves its own
+  // the first time it is swapped out
+  SetSwapExtent (-1);
+
   return 0;
 }
 
@@ -348,7 +492,8 @@ int AddrSpace::ModifySpace(OpenFile *executable)
 // --------------------------------------------------------------------------
 // AddrSpace::InitSpace(OpenFile *executable)
 // Purpose: This function will initialize a user address space with the
-//          executable parameter.  We use this version of InitSpace in
+//          executable parameter.  If the file name is given and -xcache
+//          is on, the headers come from the image cache.  We use this version of InitSpace in
 //          the system call Exec, which is passed a filename and needs
 //          to load it into memory.
 //          The difference between this InitSpace and the one that follows
@@ -358,14 +503,23 @@ int AddrSpace::ModifySpace(OpenFile *executable)
 //         executable          pointer to the open executable image
 //                             which will be loaded into memory.
 // --------------------------------------------------------------------------
-int AddrSpace::InitSpace(OpenFile *executable)
+int AddrSpace::InitSpace(OpenFile *executable, char *name)
 {
   NachosHeader nachosH;
   int retval;
   uint32_t max_address = 0U, section_size = 0U;
 
   // Get the file and section headers, and retrieve the start address
-  startAddress = ReadHeaders (executable, &nachosH);
+  if (execImageCache && (name != NULL))
+    {
+      JoinImage (LookupImage (name, executable));
+      nachosH = image->header;
+      startAddress = image->startAddress;
+    }
+  else
+    {
+      startAddress = ReadHeaders (executable, &nachosH);
+    }
 
   // How big is the address space?  VIRTUAL_MEMORY
   // Find the section with the largest starting address, add on its size, and
@@ -430,6 +584,8 @@ int AddrSpace::SetupTable() {
 	numPages, size);
 
   // first, set up the translation 
+  if (loadedSpace == this)		// the machine's table is going away
+    loadedSpace = NULL;
   pageTable = new TranslationEntry[numPages];
   if (pageTable == NULL) {
     return -ENOMEM;
@@ -446,10 +602,13 @@ int AddrSpace::SetupTable() {
     pageTable[i].offset = 0U;
     pageTable[i].zero = false;
     pageTable[i].cow = false;
+    pageTable[i].prefetched = false;
     pageTable[i].clearSC ();
     pageTable[i].setTime (0U);
     pageTable[i].clearRefHistory ();
   }
+  ResetReplacement ();
+  faultAround = faultAroundPages;
 
   return 0;
 }
@@ -489,6 +648,16 @@ AddrSpace::~AddrSpace()
   //   delete execFile;
   // }
   delete [] pageTable;
+  if (loadedSpace == this)
+    loadedSpace = NULL;
+  SetSwapExtent (-1);
+  LeaveImage ();
+  delete [] resident;
+  delete [] fifoNext;
+  delete [] fifoPrev;
+  delete [] ageNext;
+  delete [] agePrev;
+  delete [] ageKey;
 }
 
 
@@ -506,6 +675,8 @@ AddrSpace::InitRegisters()
 {
   int i;
 
+  currentThread->LoadUserState();	// the registers become ours
+
   for (i = 0; i < NumTotalRegs; i++)
     machine->WriteRegister(i, 0);
 
@@ -547,6 +718,21 @@ void AddrSpace::RestoreState()
   // FIXME: Shouldn't this function flush the TLB if there is one?
   machine->pageTable = pageTable;
   machine->pageTableSize = numPages;
+  machine->FlushTranslations ();
+  loadedSpace = this;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::IsLoaded
+// 	True if the machine still translates through this space's page
+//	table, and its translation cache holds nothing but this space's
+//	entries: nothing else has been run, and the table has not been
+//	reallocated, since RestoreState.  A switch back to this space can
+//	then skip RestoreState and keep the cached translations.
+//----------------------------------------------------------------------
+bool AddrSpace::IsLoaded() const
+{
+  return loadedSpace == this;
 }
 
 
@@ -569,6 +755,20 @@ int AddrSpace::CopyFrom(Thread *ourThread)
 
   CopyPageTable (currentThread->space->pageTable, pageTable, numPages);
 
+  // The child has the parent's resident pages with the same load times,
+  // so walking the parent's list appends them already in order
+  ResetReplacement ();
+  for (int page = currentThread->space->fifoHead; page >= 0;
+       page = currentThread->space->fifoNext[page])
+    NoteResident (page);
+  faultAround = currentThread->space->faultAround;
+  if (currentThread->space->image != NULL)
+    JoinImage (currentThread->space->image);
+
+  // The parent's pages are about to become copy-on-write, so its
+  // cached translations must no longer let stores through
+  machine->FlushTranslations ();
+
   for (i = 0; i < numPages; i++)
     {
       if (pageTable[i].File == swapfile)
@@ -579,7 +779,7 @@ int AddrSpace::CopyFrom(Thread *ourThread)
 	  pageTable[i].cow = true;
 	  currentThread->space->pageTable[i].cow = true;
 	}
-      if (pageTable[i].valid)
+      if (pageTable[i].valid && !memory->is_zero_frame (pageTable[i].physicalPage))
 	{
 	  memory->add_frame_owner (pageTable[i].physicalPage, ourThread, i);
 
@@ -607,10 +807,12 @@ void AddrSpace::duplicatePage (int virtPageNumber) {
     }
 
   memory->add_frame_owner (dest_page, currentThread, virtPageNumber);
+  machine->FlushTranslation (virtPageNumber);
 
   memcpy (&(machine->mainMemory [dest_page * PageSize]),
 	  &(machine->mainMemory [local->physicalPage * PageSize]),
 	  PageSize);
+  machine->InvalidateFrame (dest_page);
 
   memory->release_page (local->physicalPage, this);
   if (local->File == swapfile)
@@ -631,6 +833,7 @@ void AddrSpace::duplicatePage (int virtPageNumber) {
   local->clearSC ();
   local->setTime (0);
   local->clearRefHistory ();
+  NoteResident (virtPageNumber);
 }
 
 
@@ -820,17 +1023,120 @@ return numPages;
 //          currently owns
 // -----------------------------------------------------------------------
 unsigned int AddrSpace::NumPhysPagesOwned () {
-  int num = 0;
-  unsigned int i;
-  
-  for (i = 0; i < numPages; i++) {
-    if (pageTable[i].valid) {
-      num++;
+  return numResident;
+}
+
+
+// -----------------------------------------------------------------------
+// SetSwapExtent
+// Purpose: Records the run of swap frames reserved for this address
+//          space (one per page, so page N goes to frame first + N), or
+//          gives the current one back if first is -1 (or NoSwapExtent,
+//          which also stops further reservation attempts).
+// -----------------------------------------------------------------------
+void AddrSpace::SetSwapExtent (int first) {
+  if (swapExtent >= 0)
+    swap->release_extent (swapExtent, swapExtentPages);
+  swapExtent = first;
+  swapExtentPages = (first >= 0) ? numPages : 0;
+}
+
+// -----------------------------------------------------------------------
+// JoinImage / LeaveImage
+// Purpose: Add this space to (or remove it from) the list of spaces
+//          running an image in the image cache.
+// -----------------------------------------------------------------------
+void AddrSpace::JoinImage (ExecImage *theImage) {
+  image = theImage;
+  nextImageUser = image->users;
+  image->users = this;
+}
+
+void AddrSpace::LeaveImage () {
+  AddrSpace **link;
+
+  if (image == NULL)
+    return;
+  for (link = &image->users; *link != this; link = &(*link)->nextImageUser)
+    ASSERT (*link != NULL);
+  *link = nextImageUser;
+
+  // A superseded image is only kept for the spaces still running it
+  if (image->stale && (image->users == NULL))
+    {
+      ExecImage **entry;
+
+      for (entry = &execImages; *entry != image; entry = &(*entry)->next)
+	ASSERT (*entry != NULL);
+      *entry = image->next;
+      DeleteImage (image);
     }
-  }
-  return num;
+  image = NULL;
+  nextImageUser = NULL;
+}
+
+// -----------------------------------------------------------------------
+// FindSharedPage
+// Purpose: For a read-only page of our image that is not resident,
+//          returns the frame where another space running the same image
+//          holds an unmodified copy of it, or -1 if there is none.
+// -----------------------------------------------------------------------
+int AddrSpace::FindSharedPage (unsigned int virtPage) {
+  TranslationEntry *te = get_page_ptr (virtPage);
+  OpenFile *swapfile = swap->file ();
+
+  if ((image == NULL) || (te == NULL) || !te->readOnly || te->zero ||
+      (te->File == NULL) || (te->File == swapfile))
+    return -1;
+
+  for (AddrSpace *s = image->users; s != NULL; s = s->nextImageUser)
+    {
+      TranslationEntry *other = s->get_page_ptr (virtPage);
+
+      if ((s == this) || (other == NULL))
+	continue;
+      if (other->valid && !other->dirty && other->readOnly && !other->zero &&
+	  (other->File != NULL) && (other->File != swapfile) &&
+	  (other->offset == te->offset) &&
+	  !memory->is_zero_frame (other->physicalPage))
+	return other->physicalPage;
+    }
+  return -1;
 }
 
+// -----------------------------------------------------------------------
+// SpareFrames
+// Purpose: How many more frames this process can be given before it is
+//          over its working set
+// -----------------------------------------------------------------------
+int AddrSpace::SpareFrames () {
+  return wSetSize - (int)NumPhysPagesOwned();
+}
+
+// -----------------------------------------------------------------------
+// NotePrefetchHit
+// Purpose: A page fault-around read in has been referenced.  In adaptive
+//          mode the window grows back by one page, up to -fa.
+// -----------------------------------------------------------------------
+void AddrSpace::NotePrefetchHit () {
+  stats->numPrefetchHits++;
+  owner->procStats->numPrefetchHits++;
+  if (faultAroundAdaptive && (faultAround < faultAroundPages))
+    faultAround++;
+}
+
+// -----------------------------------------------------------------------
+// NotePrefetchMiss
+// Purpose: A page fault-around read in was evicted without being
+//          referenced.  In adaptive mode the window is halved, but never
+//          below one page, so that a hit can still grow it again.
+// -----------------------------------------------------------------------
+void AddrSpace::NotePrefetchMiss () {
+  stats->numPrefetchMisses++;
+  owner->procStats->numPrefetchMisses++;
+  if (faultAroundAdaptive && (faultAround > 1))
+    faultAround /= 2;
+}
 
 // -----------------------------------------------------------------------
 // TooManyFrames
@@ -858,41 +1164,14 @@ int AddrSpace::TooManyFrames () {
 //          It uses the First-In First-Out algorithm
 // -----------------------------------------------------------------------
 int AddrSpace::FIFO_Choose_Victim (int notMe) {
-  // all 678
-  int victim;                           //FIFO's chosen victim page
-  unsigned int victimTime = 0xFFFFFFFF; //set this to some temporary (max)
-                                        //value so the first page test passes
-  for(int i=0; i<getNumPages();i++)
+  // The head of the resident list has the smallest load time; only
+  // notMe can make us look past it
+  for (int i = fifoHead; i >= 0; i = fifoNext[i])
     {
-    // Check to make sure the current page is a valid one
-    // and also not the page we said it could not be
-    // otherwise it doesn't matter here
-    if(pageTable[i].valid && 
-	    (pageTable[i].physicalPage != (unsigned int) notMe))
-	    {
-            //for first page we check
-	        if(!i)
-	        {
-                //basicially automatically assign the current page to be
-                //victim page, which if more pages exist may chage later
-	            victim = pageTable[i].physicalPage;
-	            victimTime = pageTable[i].getTime();
-	        }
-            //for any additional pages
-	        if( i > 0 )
-	        {
-                //if this page was accessed at a time less then current
-                //victim, then this page is before it in the fifo queue
-                //and it becomes the victim to check against
-	            if(pageTable[i].getTime() < victimTime)
-		        {
-		            victim = pageTable[i].physicalPage;
-		            victimTime = pageTable[i].getTime();
-		        } 
-	        }
-	    }
-    } 
-  return victim;
+      if (pageTable[i].physicalPage != (unsigned int) notMe)
+	return pageTable[i].physicalPage;
+    }
+  return -1;
 }
 
 // -----------------------------------------------------------------------
@@ -905,44 +1184,34 @@ int AddrSpace::FIFO_Choose_Victim (int notMe) {
 //          It uses the Least-Recently-Used algorithm
 // -----------------------------------------------------------------------
 int AddrSpace::LRU_Choose_Victim (int notMe) {
-  unsigned int victim;                  //LRU's chosen victim page
-  unsigned char victimHist = 0xFF;      //current victim's history info
-  unsigned int victimTime = 0xFFFFFFFF; //current victim's time info
-  
-  //Loop over each page
-  for(int i=0; i<getNumPages();i++)
-  {
-    // again, make sure the ith page is valid and not the
-    // page it cannot be
-    if(pageTable[i].valid && 
-	    (pageTable[i].physicalPage != (unsigned int) notMe))
+  // The victim has the smallest history byte, and the smallest load
+  // time among those.  Pages referenced since the history was last
+  // shifted are still filed under their old (smaller) byte, so move
+  // them up as we meet them; each moves at most once per shift.
+  for (int key = 0; key < NumHistories; key++)
     {
-	    // SPECIAL CASE testing
-        // victims may have the same history records
-        if( pageTable[i].history == victimHist )
+      int i = ageHead[key];
+
+      while (i >= 0)
+	{
+	  int next = ageNext[i];
+
+	  if (pageTable[i].history != key)
 	    {
-	        // if this is the case, use the access time of the pages
-            // for victim selection
-            if( victimTime > pageTable[i].getTime() )
-		    {
-		        victim = pageTable[i].physicalPage;
-		        victimTime = pageTable[i].getTime();
-                victimHist = pageTable[i].history;
-		    }
+	      ASSERT (pageTable[i].history > key);
+	      UnlinkPage (ageNext, agePrev, &ageHead[key], &ageTail[key], i);
+	      ageKey[i] = pageTable[i].history;
+	      LinkPage (ageNext, agePrev, &ageHead[ageKey[i]],
+			&ageTail[ageKey[i]], i);
 	    }
-
-        // assuming they don't have the same history records
-        // then just use the page history data itself
-	    else if ( pageTable[i].history < victimHist )
+	  else if (pageTable[i].physicalPage != (unsigned int) notMe)
 	    {
-	        victim = pageTable[i].physicalPage;
-	        victimTime = pageTable[i].getTime();
-            victimHist = pageTable[i].history;
+	      return pageTable[i].physicalPage;
 	    }
-	  
+	  i = next;
+	}
     }
-  }
-  return victim;
+  return -1;
 }
 
 // -----------------------------------------------------------------------
@@ -987,56 +1256,29 @@ int AddrSpace::LRU_Choose_Victim (int notMe) {
 }*/
 
 int AddrSpace::SC_Choose_Victim (int notMe) {
-    int choice[4], time[4];
-    bool found_00, found_01;
+    int choice[4];
 
     for(int i=0; i<4; i++)
-    {
         choice[i] = -1;
-        time[i] = 0xFFFFFFFF;
-    }
 
-    for(int i=0; i<getNumPages();i++)
+    // Walk the resident pages oldest first, so the first page seen in
+    // each class is the one with the smallest load time.  Every page
+    // we pass loses its reference bit (its second chance), so this
+    // visits each resident page, but never the non-resident ones.
+    //
+    //   class 0 [0,0]: not used, not modified
+    //   class 1 [0,1]: not used, modified
+    //   class 2 [1,0]: used, not modified
+    //   class 3 [1,1]: used, modified
+    for(int i = fifoHead; i >= 0; i = fifoNext[i])
     {
-      // same as before, proceed only if we have a valid page
-      // and it's not our excluded page
-      if( pageTable[i].valid && 
-	        (pageTable[i].physicalPage != (unsigned int)notMe) )
-	    {
-            //valid page, now check our reference bits
-            //CASE 1 [0,0]: not used, not modified, bigger time 
-            if( !pageTable[i].use && !pageTable[i].dirty && 
-                (pageTable[i].getTime() < time[0]) )
-            {
-                choice[0] = pageTable[i].physicalPage;
-                time[0] = pageTable[i].getTime();
-            }
-            //CASE 2 [0,1]: not used, modified, bigger time
-            else if( !pageTable[i].use && pageTable[i].dirty &&
-                     (pageTable[i].getTime() < time[1]) )
-            {
-                choice[1] = pageTable[i].physicalPage;
-                time[1] = pageTable[i].getTime();
-            }
-            else
-            {
-                pageTable[i].clearSC();
+        if( pageTable[i].physicalPage == (unsigned int)notMe )
+            continue;
 
-                //CASE 3 [1,0]: used, not modified, bigger time
-                if( !pageTable[i].dirty && 
-                     (pageTable[i].getTime() < time[2]) )
-                {
-                    choice[2] = pageTable[i].physicalPage;
-                    time[2] = pageTable[i].getTime();
-                }
-                //CASE 4 [1,1]: used, modified, bigger time
-                else if( pageTable[i].getTime() < time[3] )
-                {
-                    choice[3] = pageTable[i].physicalPage;
-                    time[3] = pageTable[i].getTime();
-                }
-            }
-        }
+        int c = (pageTable[i].use ? 2 : 0) + (pageTable[i].dirty ? 1 : 0);
+        if( choice[c] < 0 )
+            choice[c] = pageTable[i].physicalPage;
+        pageTable[i].clearSC();
     }
 
     for(int i=0; i<4; i++)
@@ -1048,3 +1290,141 @@ int AddrSpace::SC_Choose_Victim (int notMe) {
     return -1;
  }
 
+// -----------------------------------------------------------------------
+// ResetReplacement
+// Purpose: (Re)allocates the replacement lists for a page table of
+//          numPages pages, none of them resident.
+// -----------------------------------------------------------------------
+void AddrSpace::ResetReplacement () {
+  delete [] resident;
+  delete [] fifoNext;
+  delete [] fifoPrev;
+  delete [] ageNext;
+  delete [] agePrev;
+  delete [] ageKey;
+
+  resident = new bool[numPages];
+  fifoNext = new int[numPages];
+  fifoPrev = new int[numPages];
+  ageNext = new int[numPages];
+  agePrev = new int[numPages];
+  ageKey = new unsigned char[numPages];
+  for (unsigned int i = 0; i < numPages; i++)
+    resident[i] = false;
+
+  numResident = 0;
+  fifoHead = fifoTail = -1;
+  for (int key = 0; key < NumHistories; key++)
+    ageHead[key] = ageTail[key] = -1;
+}
+
+// -----------------------------------------------------------------------
+// PageBefore
+// Purpose: Returns true if page a comes before page b in the order the
+//          victim choosers break ties in: load time, then page number.
+// -----------------------------------------------------------------------
+bool AddrSpace::PageBefore (int a, int b) {
+  unsigned int timeA = pageTable[a].getTime ();
+  unsigned int timeB = pageTable[b].getTime ();
+
+  return (timeA < timeB) || ((timeA == timeB) && (a < b));
+}
+
+// -----------------------------------------------------------------------
+// LinkPage
+// Purpose: Inserts a page into a list kept in PageBefore order.  Pages
+//          are almost always loaded with the newest time, or with time
+//          zero by duplicatePage, so the search starts from whichever
+//          end the page belongs nearer to.
+// -----------------------------------------------------------------------
+void AddrSpace::LinkPage (int *next, int *prev, int *head, int *tail,
+			  int page) {
+  int after = -1;
+
+  if ((*head >= 0) && !PageBefore (page, *head))
+    {
+      after = *tail;
+      while (PageBefore (page, after))
+	after = prev[after];
+    }
+
+  prev[page] = after;
+  next[page] = (after < 0) ? *head : next[after];
+  if (after < 0)
+    *head = page;
+  else
+    next[after] = page;
+  if (next[page] < 0)
+    *tail = page;
+  else
+    prev[next[page]] = page;
+}
+
+// -----------------------------------------------------------------------
+// UnlinkPage
+// Purpose: Removes a page from a list built by LinkPage.
+// -----------------------------------------------------------------------
+void AddrSpace::UnlinkPage (int *next, int *prev, int *head, int *tail,
+			    int page) {
+  if (prev[page] < 0)
+    *head = next[page];
+  else
+    next[prev[page]] = next[page];
+  if (next[page] < 0)
+    *tail = prev[page];
+  else
+    prev[next[page]] = prev[page];
+}
+
+// -----------------------------------------------------------------------
+// NoteResident
+// Purpose: Called whenever a page becomes valid, or has its load time or
+//          history reset while valid, to (re)file it on the replacement
+//          lists.
+// -----------------------------------------------------------------------
+void AddrSpace::NoteResident (unsigned int virtPage) {
+  if (virtPage >= numPages)
+    return;
+
+  NoteEvicted (virtPage);
+  resident[virtPage] = true;
+  numResident++;
+  LinkPage (fifoNext, fifoPrev, &fifoHead, &fifoTail, virtPage);
+  ageKey[virtPage] = pageTable[virtPage].history;
+  LinkPage (ageNext, agePrev, &ageHead[ageKey[virtPage]],
+	    &ageTail[ageKey[virtPage]], virtPage);
+}
+
+// -----------------------------------------------------------------------
+// NoteEvicted
+// Purpose: Called whenever a page stops being valid, to take it off the
+//          replacement lists.
+// -----------------------------------------------------------------------
+void AddrSpace::NoteEvicted (unsigned int virtPage) {
+  if ((virtPage >= numPages) || !resident[virtPage])
+    return;
+
+  UnlinkPage (fifoNext, fifoPrev, &fifoHead, &fifoTail, virtPage);
+  UnlinkPage (ageNext, agePrev, &ageHead[ageKey[virtPage]],
+	      &ageTail[ageKey[virtPage]], virtPage);
+  resident[virtPage] = false;
+  numResident--;
+}
+
+// -----------------------------------------------------------------------
+// RefileHistory
+// Purpose: Called after the history bytes have been shifted, which can
+//          lower them, to file every resident page under its new byte.
+//          Appending in load order keeps each list sorted.
+// -----------------------------------------------------------------------
+void AddrSpace::RefileHistory () {
+  for (int key = 0; key < NumHistories; key++)
+    ageHead[key] = ageTail[key] = -1;
+
+  for (int i = fifoHead; i >= 0; i = fifoNext[i])
+    {
+      ageKey[i] = pageTable[i].history;
+      LinkPage (ageNext, agePrev, &ageHead[ageKey[i]], &ageTail[ageKey[i]], i);
+    }
+}
+
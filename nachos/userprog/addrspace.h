@@ -26,6 +26,8 @@
 class Thread;
 
 #define UserStackSize		4096 	// increase this as necessary!
+#define NumHistories		256	// values of TranslationEntry::history
+#define NoSwapExtent		-2	// swapExtent after a failed reservation
 
 // Section types
 #define REGINFO 0
@@ -42,23 +44,55 @@ typedef struct nachosHeader
   Elf32_Section_header section[NUM_SECTIONS];
 } NachosHeader;
 
+class AddrSpace;
+
+// An executable that address spaces have been loaded from.  With
+// -xcache, repeated Execs of the same file take the section layout
+// from here instead of parsing the ELF headers again, and the spaces
+// currently running it are listed so that they can share text frames.
+
+class ExecImage {
+public:
+  char *name;                         // File name the image was opened by
+  int length;                         // File length when it was parsed
+  long identity, version;             // Host file and modification time
+                                      // then (stub file system only)
+  char *raw;                          // ELF and section headers as read
+  int rawSize;                        //   from the file, and their size
+  bool stale;                         // File has changed since; drop the
+                                      // entry when its last user leaves
+  NachosHeader header;                // Parsed headers
+  unsigned int startAddress;          // Entry point
+  AddrSpace *users;                   // Spaces running the image, linked
+                                      // through AddrSpace::nextImageUser
+  ExecImage *next;                    // Next image in the cache
+};
+
 class AddrSpace {
 public:
   const Thread *owner;
 
   AddrSpace (Thread *t) :
-    wSetSize(4),
     owner(t),
-    pageTable(NULL), numPages(0), execFile(NULL) {}
+    wSetSize(4),
+    faultAround(0),
+    swapExtent(-1), swapExtentPages(0),
+    image(NULL), nextImageUser(NULL),
+    pageTable(NULL), numPages(0), execFile(NULL),
+    resident(NULL), numResident(0),
+    fifoNext(NULL), fifoPrev(NULL), fifoHead(-1), fifoTail(-1),
+    ageNext(NULL), agePrev(NULL), ageKey(NULL) {}
   ~AddrSpace();			// Deallocate an address space
 
   int InitSpace(int numpages);
-  int InitSpace(OpenFile *executable);
-  int ModifySpace(OpenFile *executable);
+  int InitSpace(OpenFile *executable, char *name = NULL);
+  int ModifySpace(OpenFile *executable, char *name = NULL);
   void InitRegisters(void);		// Initialize user-level CPU registers,
   // before jumping to user code
   void SaveState(void);			// Save/restore address space-specific
   void RestoreState(void);		// info on a context switch 
+  bool IsLoaded(void) const;		// true if RestoreState need not
+					// be called to run this space
 
   TranslationEntry *get_page_ptr (unsigned int virtPage) const {
     return (virtPage >= numPages) ? NULL : &(pageTable[virtPage]);
@@ -72,15 +106,40 @@ public:
   int SC_Choose_Victim (int notMe);
   int TooManyFrames(void);
 
+  void NoteResident (unsigned int virtPage);
+  void NoteEvicted (unsigned int virtPage);
+  void RefileHistory (void);
+
   void  setWorkingSetSize(int size);
   int getWorkingSetSize(void);
   int getNumPages(void);
+  int SpareFrames(void);
+
+  int SwapExtent(void) { return swapExtent; }
+  void SetSwapExtent(int first);
+
+  int FaultAroundWindow(void) { return faultAround; }
+  void NotePrefetchHit(void);
+  void NotePrefetchMiss(void);
+
+  int FindSharedPage(unsigned int virtPage);
 
 
 private:
 
   int wSetSize;                       // Holds the size of the current
                                       // instance's working set
+  int faultAround;                    // Pages to read ahead on a fault
+  int swapExtent;                     // First swap frame reserved for our
+                                      // pages, -1 if none yet, or
+                                      // NoSwapExtent if reserving failed
+  int swapExtentPages;                // How many swap frames are reserved
+  ExecImage *image;                   // Image we were loaded from, if it
+                                      // is in the image cache
+  AddrSpace *nextImageUser;           // Next space running that image
+
+  void JoinImage(ExecImage *theImage);
+  void LeaveImage(void);
 
   void CopyPageTable (TranslationEntry *oldPT, TranslationEntry *newPT, 
 		      int numpages);
@@ -95,6 +154,26 @@ private:
   OpenFile *execFile;                 // Executable that is currently running
                                       // in this address space.  NULL if none
   unsigned int startAddress;          // Where to start executing
+
+  // Replacement bookkeeping.  The resident pages are kept on a list in
+  // the order the victim choosers break ties (load time, then virtual
+  // page number), and on a second list per value of their history
+  // byte, so that neither chooser has to scan the page table.  The lists
+  // are linked through arrays indexed by virtual page number.
+  void ResetReplacement (void);
+  bool PageBefore (int a, int b);
+  void LinkPage (int *next, int *prev, int *head, int *tail, int page);
+  void UnlinkPage (int *next, int *prev, int *head, int *tail, int page);
+
+  bool *resident;                     // Is the page on the lists below
+  unsigned int numResident;           // How many pages are
+  int *fifoNext, *fifoPrev;           // Resident pages, oldest first
+  int fifoHead, fifoTail;
+  int *ageNext, *agePrev;             // Resident pages by history byte,
+  int ageHead[NumHistories];          // oldest first within a byte
+  int ageTail[NumHistories];
+  unsigned char *ageKey;              // The byte a page is filed under;
+                                      // never above its real history
 };
 
 #endif // ADDRSPACE_H
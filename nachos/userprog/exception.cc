@@ -76,6 +76,7 @@ ExceptionHandler(ExceptionType which)
       stats->ticksAtLastPageFault = stats->userTicks;
 
       memory->pagein( virtaddr / PageSize, currentThread->space );
+      memory->fault_around( virtaddr / PageSize, currentThread->space );
     } else {
 #ifdef REMOTE_USER_PROGRAM_DEBUGGING
 	if (remoteDebugger) remoteDebugger->GDBCatchException(which);
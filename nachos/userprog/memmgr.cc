@@ -11,6 +11,7 @@
 #include "memmgr.h"
 #include "nerrno.h"
 #include "system.h"
+#include "synch.h"
 #include <machine.h>
 
 MemoryManager::MemoryManager() {
@@ -22,6 +23,18 @@ MemoryManager::MemoryManager() {
     page_flags->Clear(i);
     Frames[i].owners = NULL;
     Frames[i].numOwners = 0;
+    cleaned[i] = false;
+  }
+  clockHand = 0;
+  cleanerHand = 0;
+  cleanerWake = NULL;
+  cleanerPending = false;
+
+  zeroFrame = -1;
+  if (shareZeroPages) {
+    zeroFrame = page_flags->Find();
+    memset (&(machine->mainMemory[zeroFrame * PageSize]), 0, PageSize);
+    machine->InvalidateFrame (zeroFrame);
   }
 }
 
@@ -62,6 +75,13 @@ void MemoryManager::release_page(int page_num, AddrSpace *addrspace) {
 
   //  ASSERT (addrspace == currentThread->space);
 
+  //
+  // The zero frame is shared without being owned, and is never freed.
+  //
+  if (page_num == zeroFrame) {
+    return;
+  }
+
   //
   // Clear the page flag.
   //
@@ -69,6 +89,8 @@ void MemoryManager::release_page(int page_num, AddrSpace *addrspace) {
     page_flags->Clear(page_num);
     Frames[page_num].owners = NULL;
     Frames[page_num].numOwners = 0;
+    cleaned[page_num] = false;
+    machine->InvalidateFrame (page_num);
   } else {
     AddrSpace **newOwners;
     int j = 0;
@@ -193,8 +215,10 @@ int MemoryManager::add_frame_owner( int frame_number, Thread * thread,
 // page_number : Virtual page # to bring in.
 // addrspace   : Pointer to thread's address space object (containing its
 //               page table).
+// prefetch    : True if nobody has asked for the page yet (fault-around).
 
-void MemoryManager::pagein( int page_number, AddrSpace * addrspace ) {
+void MemoryManager::pagein( int page_number, AddrSpace * addrspace,
+			    bool prefetch ) {
   TranslationEntry* local;
   int dest_frame;
   OpenFile *swapfile = swap->file();
@@ -204,19 +228,67 @@ void MemoryManager::pagein( int page_number, AddrSpace * addrspace ) {
   // that we are going to bring in.
   //
   local = addrspace->get_page_ptr( page_number );
+
+  //
+  // A zero-fill page nobody has written yet can share the zero frame;
+  // the first write copies it like any other copy-on-write page. It
+  // uses no frame of its own, so it is not put on the replacement lists.
+  //
+  if ((zeroFrame >= 0) && local->zero && !prefetch) {
+    local->valid = true;
+    local->use = false;
+    local->dirty = false;
+    local->cow = true;
+    local->prefetched = false;
+    local->physicalPage = zeroFrame;
+    local->clearSC ();
+    local->setTime (stats->totalTicks);
+    stats->numZeroPageMaps++;
+    return;
+  }
+
+  //
+  // A text page another instance of the same executable has resident
+  // can be shared with it, copy-on-write, instead of being read again.
+  //
+  if ((dest_frame = addrspace->FindSharedPage( page_number )) >= 0) {
+    add_owner_space( dest_frame, addrspace );
+    for (int i = 0; i < Frames[ dest_frame ].numOwners; i++) {
+      Frames[ dest_frame ].owners[i]->get_page_ptr (page_number)->cow = true;
+    }
+    machine->FlushTranslation (page_number);
+    local->valid = true;
+    local->use = false;
+    local->dirty = false;
+    local->prefetched = prefetch;
+    local->physicalPage = dest_frame;
+    local->clearSC ();
+    local->setTime (stats->totalTicks);
+    addrspace->NoteResident (page_number);
+    stats->numSharedTextMaps++;
+    return;
+  }
   
   //
   // Try to find a free memory frame for it.
   //
   if ( ( dest_frame = get_next_free_page() ) < 0 ) {
     // 
-    // There was no free memory frame, so we are going to choose a victim
-    // page, swap it out, and then use it's frame to bring in the page we
-    // want. 
+    // There was no free memory frame we may use. If memory is really
+    // full (rather than this process over its working set), merging
+    // identical frames may free one; otherwise we are going to choose a
+    // victim page, swap it out, and then use it's frame to bring in the
+    // page we want.
     //
-    dest_frame = Choose_Victim(-1);
-    pageout( dest_frame );
+    if (!dedupPages || (page_flags->NumClear() != 0) ||
+	(dedup_pass() == 0) || (page_flags->NumClear() == 0) ||
+	((dest_frame = get_next_free_page()) < 0)) {
+      dest_frame = Choose_Victim(-1);
+      pageout( dest_frame );
+      wake_cleaner();
+    }
   }
+  cleaned[ dest_frame ] = false;
 
   //
   // If the page is supposed to be filled with zeroes, then we do that, 
@@ -229,6 +301,7 @@ void MemoryManager::pagein( int page_number, AddrSpace * addrspace ) {
   } else {    
     memset (&(machine->mainMemory [dest_frame * PageSize]), 0, PageSize);
   }
+  machine->InvalidateFrame (dest_frame);
 
   //
   // Initialize the frame record for the memory frame. This is done 
@@ -280,8 +353,10 @@ void MemoryManager::pagein( int page_number, AddrSpace * addrspace ) {
     te->use = false;
     te->dirty = false;
     te->physicalPage = dest_frame;
+    te->prefetched = prefetch;
     te->clearSC ();
     te->setTime (stats->totalTicks);
+    Frames[ dest_frame ].owners[i]->NoteResident (page_number);
   }
 
   stats->numPageIns++;
@@ -291,6 +366,37 @@ void MemoryManager::pagein( int page_number, AddrSpace * addrspace ) {
 }
 
 
+// MemoryManager::fault_around
+//
+// Read ahead the pages following a page that just faulted in.
+//
+// Arguments:
+// page_number : Virtual page # that faulted.
+// addrspace   : Pointer to thread's address space object.
+
+void MemoryManager::fault_around( int page_number, AddrSpace * addrspace ) {
+  TranslationEntry *faulted = addrspace->get_page_ptr (page_number);
+  int window = addrspace->FaultAroundWindow ();
+
+  if (faulted->zero) {
+    return;
+  }
+
+  for (int k = 1; k <= window; k++) {
+    TranslationEntry *te = addrspace->get_page_ptr (page_number + k);
+
+    if ((te == NULL) || te->valid || te->zero || (te->File != faulted->File)
+	|| (te->offset != faulted->offset + k * PageSize)) {
+      break;
+    }
+    if ((addrspace->SpareFrames () <= 0) || (page_flags->NumClear () == 0)) {
+      break;
+    }
+    pagein (page_number + k, addrspace, true);
+  }
+}
+
+
 // MemoryManager::pageout
 //
 // Swap a page out of main memory.
@@ -300,7 +406,6 @@ void MemoryManager::pagein( int page_number, AddrSpace * addrspace ) {
 
 void MemoryManager::pageout( int victim ) {
   OpenFile * swapfile = swap->file();
-  int swap_num;
   TranslationEntry *local;
 
   ASSERT (Frames[ victim ].owners != NULL);
@@ -321,35 +426,13 @@ void MemoryManager::pageout( int victim ) {
   //
   if (local->dirty)  // It is dirty.
     {
-      if (local->File != swapfile) //never been swapped out
-	{
-	  // 
-	  // Get the next free frame in the swap file. If there isn't one,
-	  // we're in pretty bad shape, so we just assert to get out.
-	  //
-	  swap_num = swap->get_next_free_frame(); 
-	  ASSERT (swap_num >= 0);
-
-	  // 
-	  // Go through the list of owners, and change the translation entries
-	  // for the page being swapped out in their page tables, so that they
-	  // are aware that the page has been swapped out when they try to
-	  // reference it later.
-	  //
-	  for (int i = 0; i < Frames[ victim ].numOwners; i++)
-	    {
-	      TranslationEntry *te = Frames[ victim ].owners[i]->
-		get_page_ptr ( Frames[ victim ].owners_page_number);
-	      te->File = swapfile;
-	      te->offset = swap_num * PageSize;
-	      te->zero = false;
-	    }
-	}
+      assign_swap_frame (victim);
 
       swapfile->WriteAt (&(machine->mainMemory[victim * PageSize]), PageSize,
 			 local->offset);
 
       stats->numPageOuts++;
+      stats->numWriteBehindMisses++;
       for (int i = 0; i < Frames[ victim ].numOwners; i++)
 	{
 	  Frames[victim].owners[i]->owner->procStats->numPageOuts++;
@@ -357,6 +440,13 @@ void MemoryManager::pageout( int victim ) {
     }
   else
     {
+      // If the page cleaner already wrote the page out, the write we just
+      // avoided is a write-behind hit
+      if (cleaned[ victim ])
+	{
+	  stats->numWriteBehindHits++;
+	}
+
       // If we don't need to swap out, and we'll swap back in from something
       // other than the swapfile, clear the COW so that each process will
       // swap it's own copy of the page back in when necessary
@@ -373,39 +463,105 @@ void MemoryManager::pageout( int victim ) {
 
   if (local->File == swapfile)
     {
-      // 
-      // Set the frame record in the swapfile.
-      //
-      Frame *frame = swap->get_frame (local->offset);
-      if (frame->owners != NULL)
-	{
-	  delete [] frame->owners; 
-	}
-      frame->owners = new AddrSpace *[ Frames[victim].numOwners ];
-      for (int i = 0; i < Frames[victim].numOwners ; i++)
-	{
-	  frame->owners[i] = Frames[victim].owners[i];
-	}
-
-      frame->owners_page_number = Frames[ victim ].owners_page_number;
-      frame->numOwners =  Frames[ victim ].numOwners;
+      set_swap_record (victim);
     }
+  cleaned[ victim ] = false;
 
   // 
   // For each of the owners, set the valid bit of the page table entries 
   // for the page to false.
   //
+  machine->FlushTranslation (Frames[ victim ].owners_page_number);
   for (int i = 0; i < Frames[ victim ].numOwners; i++)
     {
       TranslationEntry *te = Frames[ victim ].owners[i]->
 	get_page_ptr ( Frames[ victim ].owners_page_number);
       te->valid = false;
+      Frames[ victim ].owners[i]->NoteEvicted
+	(Frames[ victim ].owners_page_number);
+      if (te->prefetched)
+	{
+	  te->prefetched = false;
+	  Frames[ victim ].owners[i]->NotePrefetchMiss ();
+	}
     }
 
   // Clear out old information
   delete [] (Frames[victim].owners);
   Frames[victim].owners = NULL;
   Frames[victim].numOwners = 0;
+  machine->InvalidateFrame (victim);
+}
+
+// MemoryManager::assign_swap_frame
+//
+// Make sure a page has a frame in the swap file to be written to. If it
+// has never been swapped out, get the next free swap frame and point the
+// translation entries of all the owners at it.
+//
+// Arguments:
+// frame    : Physical page number of the page.
+
+void MemoryManager::assign_swap_frame( int frame ) {
+  OpenFile * swapfile = swap->file();
+  TranslationEntry *local = Frames[ frame ].owners[0]->
+    get_page_ptr ( Frames[ frame ].owners_page_number);
+  int swap_num;
+
+  if (local->File == swapfile) //already swapped out once
+    {
+      return;
+    }
+
+  // 
+  // Get the next free frame in the swap file. If there isn't one,
+  // we're in pretty bad shape, so we just assert to get out.
+  //
+  swap_num = swap->get_next_free_frame(Frames[ frame ].owners[0],
+				       Frames[ frame ].owners_page_number);
+  ASSERT (swap_num >= 0);
+
+  // 
+  // Go through the list of owners, and change the translation entries
+  // for the page being swapped out in their page tables, so that they
+  // are aware that the page has been swapped out when they try to
+  // reference it later.
+  //
+  for (int i = 0; i < Frames[ frame ].numOwners; i++)
+    {
+      TranslationEntry *te = Frames[ frame ].owners[i]->
+	get_page_ptr ( Frames[ frame ].owners_page_number);
+      te->File = swapfile;
+      te->offset = swap_num * PageSize;
+      te->zero = false;
+    }
+}
+
+// MemoryManager::set_swap_record
+//
+// Copy the owners of a page that lives in the swap file into the frame
+// record for its swap frame, so pagein can restore them.
+//
+// Arguments:
+// frame    : Physical page number of the page.
+
+void MemoryManager::set_swap_record( int frame ) {
+  TranslationEntry *local = Frames[ frame ].owners[0]->
+    get_page_ptr ( Frames[ frame ].owners_page_number);
+  Frame *record = swap->get_frame (local->offset);
+
+  if (record->owners != NULL)
+    {
+      delete [] record->owners; 
+    }
+  record->owners = new AddrSpace *[ Frames[frame].numOwners ];
+  for (int i = 0; i < Frames[frame].numOwners ; i++)
+    {
+      record->owners[i] = Frames[frame].owners[i];
+    }
+
+  record->owners_page_number = Frames[ frame ].owners_page_number;
+  record->numOwners =  Frames[ frame ].numOwners;
 }
 
 // MemoryManager::Choose_Victim
@@ -419,7 +575,15 @@ void MemoryManager::pageout( int victim ) {
 int MemoryManager::Choose_Victim (int notMe) {
   int page = -1;
   
-  if ((pageReplPolicy == DUMB) || (!currentThread->space->TooManyFrames())) {
+  if (pageReplPolicy == GLOBALCLOCK) {
+    // Global, but a process over its working set pays for its own faults
+    if (currentThread->space->TooManyFrames()) {
+      page = Clock_Choose_Victim (notMe, currentThread->space);
+    } else {
+      page = Clock_Choose_Victim (notMe, NULL);
+    }
+  } else if ((pageReplPolicy == DUMB) ||
+	     (!currentThread->space->TooManyFrames())) {
     page = Dumb_Choose_Victim (notMe);
   } else if (pageReplPolicy == FIFO) {
     page = currentThread->space->FIFO_Choose_Victim (notMe);
@@ -448,4 +612,340 @@ int MemoryManager::Dumb_Choose_Victim (int notMe) {
 
   return i;
 }
+
+// MemoryManager::Clock_Choose_Victim
+//
+// Sweep the clock hand over the frames in use. A frame whose page was
+// referenced since the hand last passed (by any of its owners) has its
+// reference bits cleared and is skipped; the first frame that was not
+// referenced is the victim. Two full sweeps always find one.
+//
+// Arguments:
+// notMe    : The number of a frame that you do not want swapped out.
+// only     : If not NULL, consider only frames this address space owns.
+
+int MemoryManager::Clock_Choose_Victim (int notMe, AddrSpace *only) {
+  for (int n = 0; n < 2 * NumPhysPages; n++) {
+    int frame = clockHand;
+
+    clockHand = (clockHand + 1) % NumPhysPages;
+    if ((frame == notMe) || (Frames[frame].owners == NULL)) {
+      continue;
+    }
+    if (only != NULL) {
+      bool owned = false;
+      for (int i = 0; i < Frames[frame].numOwners; i++) {
+	if (Frames[frame].owners[i] == only) {
+	  owned = true;
+	}
+      }
+      if (!owned) {
+	continue;
+      }
+    }
+    if (!ClearReferenced (frame)) {
+      return frame;
+    }
+  }
+
+  return -1;
+}
+
+// MemoryManager::ClearReferenced
+//
+// Returns true if any owner of a frame has used its page, and clears
+// the use bits so the page must be used again to stay resident.
+
+bool MemoryManager::ClearReferenced (int frame) {
+  bool used = false;
+
+  for (int i = 0; i < Frames[frame].numOwners; i++) {
+    TranslationEntry *te = Frames[frame].owners[i]->
+      get_page_ptr (Frames[frame].owners_page_number);
+    if (te->use) {
+      used = true;
+      te->clearSC ();
+    }
+  }
+  return used;
+}
+
+// The page cleaner writes at most this many pages each time it wakes up.
+#define CleanBatch 16
+
+// PageCleaner
+//
+// Body of the page cleaner thread.
+
+static void PageCleaner (size_t) {
+  for (;;) {
+    memory->clean_pages ();
+  }
+}
+
+// MemoryManager::StartCleaner
+//
+// Fork the page cleaner thread. It runs once to go to sleep, and after
+// that whenever pagein had to evict a page.
+
+void MemoryManager::StartCleaner() {
+  Thread *t = new Thread();
+  IntStatus oldLevel;
+
+  cleanerWake = new KernelSemaphore((char *)"page cleaner", 0);
+  t->SetName ((char *)"page cleaner");
+  t->Fork (PageCleaner, (size_t)0);
+
+  oldLevel = interrupt->SetLevel(IntOff);
+  scheduler->ReadyToRun(t);
+  (void) interrupt->SetLevel(oldLevel);
+}
+
+// MemoryManager::wake_cleaner
+//
+// Let the page cleaner run, unless it is already due to.
+
+void MemoryManager::wake_cleaner() {
+  if ((cleanerWake != NULL) && !cleanerPending) {
+    cleanerPending = true;
+    cleanerWake->V();
+  }
+}
+
+// MemoryManager::clean_pages
+//
+// Sleep until woken, then sweep the cleaner's hand over the frames and
+// write up to CleanBatch dirty, cold frames to swap. A frame is cold if
+// none of its owners has referenced it since their reference history
+// was last shifted. Pages are written in order of their swap frame, one
+// WriteAt per run of contiguous swap frames.
+
+void MemoryManager::clean_pages() {
+  static char cluster[CleanBatch * PageSize];
+  OpenFile *swapfile = swap->file();
+  int batch[CleanBatch];
+  int count = 0;
+  IntStatus oldLevel;
+
+  cleanerWake->P();
+  oldLevel = interrupt->SetLevel(IntOff);
+  cleanerPending = false;
+
+  for (int n = 0; (n < NumPhysPages) && (count < CleanBatch); n++) {
+    int frame = cleanerHand;
+    bool cold = true;
+
+    cleanerHand = (cleanerHand + 1) % NumPhysPages;
+    if (Frames[frame].owners == NULL) {
+      continue;
+    }
+    for (int i = 0; i < Frames[frame].numOwners; i++) {
+      TranslationEntry *te = Frames[frame].owners[i]->
+	get_page_ptr (Frames[frame].owners_page_number);
+      if (te->history & 0x80) {
+	cold = false;
+      }
+    }
+    if (!cold || !Frames[frame].owners[0]->
+	get_page_ptr (Frames[frame].owners_page_number)->dirty) {
+      continue;
+    }
+
+    assign_swap_frame (frame);
+    batch[count++] = frame;
+  }
+
+  // Sort the batch by swap offset (it is small, so insertion sort)
+  for (int i = 1; i < count; i++) {
+    int frame = batch[i];
+    size_t offset = Frames[frame].owners[0]->
+      get_page_ptr (Frames[frame].owners_page_number)->offset;
+    int j = i;
+
+    while ((j > 0) && (Frames[batch[j - 1]].owners[0]->
+		       get_page_ptr (Frames[batch[j - 1]].owners_page_number)
+		       ->offset > offset)) {
+      batch[j] = batch[j - 1];
+      j--;
+    }
+    batch[j] = frame;
+  }
+
+  // Write each run of contiguous swap frames with a single WriteAt
+  for (int first = 0; first < count; ) {
+    size_t start = Frames[batch[first]].owners[0]->
+      get_page_ptr (Frames[batch[first]].owners_page_number)->offset;
+    int last = first;
+
+    while ((last + 1 < count) &&
+	   (Frames[batch[last + 1]].owners[0]->
+	    get_page_ptr (Frames[batch[last + 1]].owners_page_number)->offset
+	    == start + (last + 1 - first) * PageSize)) {
+      last++;
+    }
+    for (int i = first; i <= last; i++) {
+      memcpy (&cluster[(i - first) * PageSize],
+	      &(machine->mainMemory[batch[i] * PageSize]), PageSize);
+    }
+    swapfile->WriteAt (cluster, (last - first + 1) * PageSize, start);
+    stats->numClustersWritten++;
+    first = last + 1;
+  }
+
+  // The frames now match their swap copies
+  for (int i = 0; i < count; i++) {
+    int frame = batch[i];
+
+    for (int o = 0; o < Frames[frame].numOwners; o++) {
+      Frames[frame].owners[o]->
+	get_page_ptr (Frames[frame].owners_page_number)->dirty = false;
+    }
+    set_swap_record (frame);
+    cleaned[frame] = true;
+  }
+  stats->numPagesCleaned += count;
+  DEBUG( (char *)DB_ADDRESS , (char *)"Page cleaner wrote %d pages\n", count);
+
+  (void) interrupt->SetLevel(oldLevel);
+}
+
+// MemoryManager::can_merge
+//
+// Returns true if a frame may be shared by more address spaces: it is in
+// use, it is not the zero frame, and no owner has dirtied it or keeps it
+// in the swap file (a clean frame is simply dropped on eviction, and each
+// owner pages its own copy back in).
+
+bool MemoryManager::can_merge( int frame ) {
+  OpenFile *swapfile = swap->file();
+
+  if ((Frames[frame].owners == NULL) || (frame == zeroFrame)) {
+    return false;
+  }
+  for (int i = 0; i < Frames[frame].numOwners; i++) {
+    TranslationEntry *te = Frames[frame].owners[i]->
+      get_page_ptr (Frames[frame].owners_page_number);
+    if (te->dirty || (te->File == swapfile)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// MemoryManager::merge_frames
+//
+// Move every owner of frame "from" onto frame "into", which holds the
+// same virtual page with the same contents, make all of them
+// copy-on-write, and free "from".
+
+void MemoryManager::merge_frames( int from, int into ) {
+  int page = Frames[into].owners_page_number;
+  AddrSpace **newOwners =
+    new AddrSpace *[Frames[into].numOwners + Frames[from].numOwners];
+  int n = 0;
+
+  for (int i = 0; i < Frames[into].numOwners; i++) {
+    newOwners[n++] = Frames[into].owners[i];
+  }
+  for (int i = 0; i < Frames[from].numOwners; i++) {
+    newOwners[n++] = Frames[from].owners[i];
+  }
+  delete [] Frames[into].owners;
+  delete [] Frames[from].owners;
+  Frames[into].owners = newOwners;
+  Frames[into].numOwners = n;
+
+  for (int i = 0; i < n; i++) {
+    TranslationEntry *te = newOwners[i]->get_page_ptr (page);
+    te->physicalPage = into;
+    te->cow = true;
+  }
+  machine->FlushTranslation (page);
+
+  page_flags->Clear(from);
+  Frames[from].owners = NULL;
+  Frames[from].numOwners = 0;
+  cleaned[from] = false;
+  machine->InvalidateFrame (from);
+  stats->numPagesMerged++;
+}
+
+// MemoryManager::dedup_pass
+//
+// Merge frames with identical contents. Frames are hashed (FNV-1a over
+// the page, mixed with the virtual page number) into an open-addressed
+// table; only frames whose hashes match are compared byte for byte.
+
+int MemoryManager::dedup_pass() {
+  int table[2 * NumPhysPages];
+  unsigned int hash[NumPhysPages];
+  int merged = 0;
+
+  for (int i = 0; i < 2 * NumPhysPages; i++) {
+    table[i] = -1;
+  }
+
+  for (int frame = 0; frame < NumPhysPages; frame++) {
+    unsigned char *bytes;
+    int slot;
+
+    if (!can_merge (frame)) {
+      continue;
+    }
+
+    bytes = (unsigned char *) &(machine->mainMemory[frame * PageSize]);
+    hash[frame] = 2166136261U ^ Frames[frame].owners_page_number;
+    for (int b = 0; b < PageSize; b++) {
+      hash[frame] = (hash[frame] ^ bytes[b]) * 16777619U;
+    }
+
+    for (slot = hash[frame] % (2 * NumPhysPages); table[slot] >= 0;
+	 slot = (slot + 1) % (2 * NumPhysPages)) {
+      int other = table[slot];
+      bool disjoint = true;
+
+      if ((hash[other] != hash[frame]) ||
+	  (Frames[other].owners_page_number !=
+	   Frames[frame].owners_page_number) ||
+	  memcmp (bytes, &(machine->mainMemory[other * PageSize]), PageSize)) {
+	continue;
+      }
+      for (int i = 0; i < Frames[frame].numOwners; i++) {
+	for (int j = 0; j < Frames[other].numOwners; j++) {
+	  if (Frames[frame].owners[i] == Frames[other].owners[j]) {
+	    disjoint = false;
+	  }
+	}
+      }
+      if (disjoint) {
+	merge_frames (frame, other);
+	merged++;
+	break;
+      }
+    }
+    if ((table[slot] < 0) && (Frames[frame].owners != NULL)) {
+      table[slot] = frame;
+    }
+  }
+
+  DEBUG( (char *)DB_ADDRESS , (char *)"Dedup pass merged %d frames\n", merged);
+  return merged;
+}
+
+// MemoryManager::add_owner_space
+//
+// Like add_frame_owner, for an address space rather than a thread.
+
+void MemoryManager::add_owner_space( int frame, AddrSpace *addrspace ) {
+  AddrSpace **newOwners = new AddrSpace *[Frames[frame].numOwners + 1];
+
+  for (int i = 0; i < Frames[frame].numOwners; i++) {
+    ASSERT (Frames[frame].owners[i] != addrspace);
+    newOwners[i] = Frames[frame].owners[i];
+  }
+  newOwners[Frames[frame].numOwners] = addrspace;
+  delete [] Frames[frame].owners;
+  Frames[frame].owners = newOwners;
+  Frames[frame].numOwners++;
+}
 #endif
@@ -18,6 +18,7 @@
 #include "machine.h"
 
 class AddrSpace;
+class KernelSemaphore;
 
 struct Frame {          // VIRTUAL_MEMORY
   AddrSpace **owners;
@@ -55,6 +56,31 @@ class Thread;
 //
 //    Arguments:
 //    page_num : The number of the page to release.
+//
+//  MemoryManager::fault_around
+//    After a fault on page_number has been serviced, read in the pages that
+//    follow it, as long as they are not resident, come from the same run
+//    of the same file, and free frames within the working set remain.
+//    The window is the address space's FaultAroundWindow().
+//
+//  MemoryManager::dedup_pass
+//    Hash the contents of every frame that can be shared (clean, not
+//    backed by swap) and merge frames with identical contents that hold
+//    the same virtual page of different address spaces into one
+//    copy-on-write frame, the same way fork shares frames. Returns the
+//    number of frames freed.
+//
+//  MemoryManager::StartCleaner
+//    Fork the page cleaner, a kernel thread that sleeps until an eviction
+//    finds memory full and then writes a batch of dirty frames that have
+//    not been referenced since the last working-set refresh to swap,
+//    grouped into runs of contiguous swap slots. Those frames stay
+//    resident but are clean, so evicting them later needs no write.
+//
+//  MemoryManager::Clock_Choose_Victim
+//    Choose a victim with the CLOCK algorithm over all of Frames[], using
+//    the use bits of every owner of a frame as its reference bit. If
+//    "only" is not NULL, frames it does not own are passed over.
 //---------------------------------------------------------------------------
 
 class MemoryManager {
@@ -66,7 +92,9 @@ public:
   // called to free a page that was used 
   void release_page(int page_num, AddrSpace *addrspace); 
 
-  void pagein( int page_number, AddrSpace * addrspace );
+  void pagein( int page_number, AddrSpace * addrspace,
+	       bool prefetch = false );
+  void fault_around( int page_number, AddrSpace * addrspace );
   void pageout( int victim );
   Frame *get_frame( int number );
   int add_frame_owner ( int frame_number, Thread * thread, int owner_page );
@@ -79,12 +107,40 @@ public:
 
   int Choose_Victim (int notMe);
   int Dumb_Choose_Victim (int notMe);
+  int Clock_Choose_Victim (int notMe, AddrSpace *only);
+
+  bool is_zero_frame( int frame ) { return frame == zeroFrame; }
+  int dedup_pass();
+
+  void StartCleaner();
+  void clean_pages();
 
 private:
+  bool ClearReferenced (int frame);
+  void assign_swap_frame( int frame );
+  void set_swap_record( int frame );
+  void wake_cleaner();
+  bool can_merge( int frame );
+  void merge_frames( int from, int into );
+  void add_owner_space( int frame, AddrSpace *addrspace );
+
   BitMap *page_flags;
   
   Frame Frames[NumPhysPages];  // array of information on each frame
   // so we can do virtual memory. VIRTUAL_MEMORY
+
+  int clockHand;               // next frame the global clock looks at
+
+  bool cleaned[NumPhysPages];  // written to swap by the cleaner since
+                               // it was paged in
+  int cleanerHand;             // next frame the cleaner looks at
+  KernelSemaphore *cleanerWake;// the cleaner sleeps on this; NULL if
+                               // it was not started
+  bool cleanerPending;         // cleanerWake has been signalled
+
+  int zeroFrame;               // frame of zeroes that untouched zero-fill
+                               // pages share copy-on-write; -1 if none.
+                               // It has no owners and is never evicted
 };
 
 #endif
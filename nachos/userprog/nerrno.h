@@ -16,7 +16,9 @@
 #define ECHILD 10
 #define EAGAIN 11
 #define ENOMEM 12
+#define EINVAL 22
 #define EMFILE 24
+#define EFAULT 14
 
 #endif
 
@@ -33,7 +33,7 @@ StartProcess(char *filename)
     }
     space = new AddrSpace (currentThread);
     currentThread->space = space;
-    space->InitSpace(executable);
+    space->InitSpace(executable, filename);
 //        delete executable;			// close file
 
     space->InitRegisters();		// set the initial register values
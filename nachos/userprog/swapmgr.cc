@@ -21,8 +21,10 @@ SwapManager::SwapManager() {
   // Clear all the frame flags. This means that all frames are free.
   //
   frame_flags = new BitMap(NumSwapPages);
+  reserved = new BitMap(NumSwapPages);
   for (int i = 0; i < NumSwapPages; i++) {
     frame_flags->Clear(i);
+    reserved->Clear(i);
     Frames[i].owners = NULL;
     Frames[i].numOwners = 0;
   }
@@ -41,11 +43,39 @@ SwapManager::~SwapManager() {
   unlink (SwapFileName);
 }
 
-int SwapManager::get_next_free_frame() {
+int SwapManager::get_next_free_frame(AddrSpace *addrspace, int page) {
+  int free_frame = -1;
+
+  //
+  // Try the page's own frame in its address space's extent, reserving
+  // the extent first if this is the space's first trip to swap. A space
+  // whose reservation already failed skips straight to the loose frames
+  // rather than rescanning swap for a run on every pageout.
+  //
+  if (addrspace != NULL) {
+    int first = addrspace->SwapExtent();
+
+    if ((first == -1) && (addrspace->getNumPages() > 0)) {
+      first = reserve_extent(addrspace->getNumPages());
+      addrspace->SetSwapExtent((first >= 0) ? first : NoSwapExtent);
+    }
+    if ((first >= 0) && (page < addrspace->getNumPages()) &&
+	!frame_flags->Test(first + page)) {
+      free_frame = first + page;
+      frame_flags->Mark(free_frame);
+    }
+  }
+
   //
-  // Find the first frame flag that == 0, and set it to 1. 
+  // Otherwise, take the first free frame outside every extent, or if
+  // there is none, find the first frame flag that == 0, and set it to 1.
   //
-  int free_frame = frame_flags->Find();
+  if (free_frame == -1) {
+    free_frame = find_unreserved_frame();
+  }
+  if (free_frame == -1) {
+    free_frame = frame_flags->Find();
+  }
 
   //
   // If there was no clear frame flag, set nerrno to reflect the fact that
@@ -61,6 +91,46 @@ int SwapManager::get_next_free_frame() {
   return free_frame;
 }
 
+int SwapManager::find_unreserved_frame() {
+  for (int i = 0; i < NumSwapPages; i++) {
+    if (!frame_flags->Test(i) && !reserved->Test(i)) {
+      frame_flags->Mark(i);
+      return i;
+    }
+  }
+  return -1;
+}
+
+int SwapManager::reserve_extent(int pages) {
+  int run = 0;
+
+  //
+  // First fit: the first run of frames that are neither in use nor
+  // reserved and is long enough.
+  //
+  for (int i = 0; i < NumSwapPages; i++) {
+    if (frame_flags->Test(i) || reserved->Test(i)) {
+      run = 0;
+      continue;
+    }
+    if (++run == pages) {
+      int first = i - pages + 1;
+
+      for (int j = first; j <= i; j++) {
+	reserved->Mark(j);
+      }
+      return first;
+    }
+  }
+  return -1;
+}
+
+void SwapManager::release_extent(int first, int pages) {
+  for (int i = first; i < first + pages; i++) {
+    reserved->Clear(i);
+  }
+}
+
 void SwapManager::release_frame(size_t offset, AddrSpace *addrspace) {
   int frame_num = (int) (offset / PageSize);
 
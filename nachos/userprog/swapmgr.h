@@ -33,6 +33,16 @@ extern char *SwapFileName;
 //   This is the default destructor. It does nothing for now.
 //
 // SwapManager::get_next_free_frame
+//   Allocate a swap frame for virtual page "page" of "addrspace". Each
+//   address space reserves an extent of contiguous swap frames, one per
+//   virtual page, the first time it needs one, and page N is placed at
+//   frame N of its extent, so that neighbouring pages are neighbours on
+//   disk. If the space has no extent or that frame is taken, any frame no
+//   extent has reserved is used, and failing that any free frame at all.
+//
+//   Arguments:
+//   addrspace : The address space the page belongs to, or NULL
+//   page      : The virtual page number within it
 // 
 //   Return value:
 //   Normal                : The number of the next free frame
@@ -42,6 +52,11 @@ extern char *SwapFileName;
 //
 //    Arguments:
 //    offset : the offset of the frame to release
+//
+//  SwapManager::reserve_extent / release_extent
+//    Reserve (or give back) a run of "pages" contiguous swap frames that
+//    are neither in use nor reserved. reserve_extent returns the first
+//    frame of the run, or -1 if there is no such run.
 //---------------------------------------------------------------------------
 
 class SwapManager {
@@ -49,7 +64,10 @@ public:
   SwapManager();          // Clears all the bits in the page_flags bitmap
   ~SwapManager();         // do-nothing 
 
-  int get_next_free_frame(); // returns the number of the next free page
+  // returns the number of the next free page
+  int get_next_free_frame(AddrSpace *addrspace = NULL, int page = 0);
+  int reserve_extent(int pages);
+  void release_extent(int first, int pages);
   // called to free a page that was used 
   void release_frame(size_t offset, AddrSpace *addrspace); 
   Frame * get_frame(size_t offset);
@@ -65,7 +83,10 @@ public:
   }
 
 private:
+  int find_unreserved_frame();
+
   BitMap *frame_flags;
+  BitMap *reserved;            // frames inside some address space's extent
   OpenFile *swapFile;
   Frame Frames[NumSwapPages];  // array of information on each frame
                                // so we can do virtual memory. VIRTUAL_MEMORY
@@ -97,6 +97,11 @@ int Read(OpenFileId id, void *buffer, unsigned int size);
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
+/* Return only once everything written to the file has reached the
+ * disk, even if the file system is caching writes.
+ */
+int Fsync(OpenFileId id);
+
 /* Delete a file */
 int Unlink (char *filename);
 
@@ -130,6 +135,30 @@ int GetPPID();
 int Nice (int inc);
 
 
+/*
+ * Futexes: the building block of locks and semaphores between
+ * processes.  The kernel keeps NumFutexes words, all starting at 0,
+ * that every process shares; a futex is named by its number.
+ *
+ * FutexWait puts the caller to sleep on "futex" if its word still
+ * holds "val" (else it returns -1 at once, with errno EAGAIN), until a
+ * FutexWake on the same futex.  FutexWake wakes at most "count"
+ * sleepers, from any process, oldest first, and returns how many it
+ * woke.  FutexAdd adds "delta" to the word and returns the new value,
+ * unless that would be below 0, when it returns -1 with errno EAGAIN
+ * and leaves the word alone.  A bad futex number gives errno EINVAL.
+ *
+ * A semaphore, for example, is taken with
+ *	while (FutexAdd (f, -1) < 0) FutexWait (f, 0);
+ * and released with
+ *	FutexAdd (f, 1); FutexWake (f, 1);
+ * so an available semaphore is taken with one system call, and a
+ * waiter sleeps instead of spinning through the scheduler.
+ */
+int FutexWait (int futex, int val);
+int FutexWake (int futex, int count);
+int FutexAdd (int futex, int delta);
+
 /*
  * -----------------------------------------------------
  * Nachos User-Level Datastream Event
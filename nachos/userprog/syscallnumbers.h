@@ -25,6 +25,13 @@
 
 #define SC_NachosUserEvent    16
 
+#define SC_FutexWait    17
+#define SC_FutexWake    18
+#define SC_Fsync        19
+#define SC_FutexAdd     20
+
+#define NumFutexes      64	/* futex words kept by the kernel */
+
 #define SC_NameThread       25
 
 #endif
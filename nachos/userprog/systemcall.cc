@@ -62,6 +62,9 @@ void do_system_call(int syscall_num) {
   case SC_Close:    
     returnvalue = System_Close ((int) reg4);
     break;
+  case SC_Fsync:
+    returnvalue = System_Fsync ((int) reg4);
+    break;
   case SC_Unlink:
     returnvalue = System_Unlink ((char *) reg4);
     break;
@@ -87,6 +90,15 @@ void do_system_call(int syscall_num) {
   case SC_NameThread:
     returnvalue = System_NameThread((char *) reg4);
     break;
+  case SC_FutexWait:
+    returnvalue = System_FutexWait ((int) reg4, (int) reg5);
+    break;
+  case SC_FutexWake:
+    returnvalue = System_FutexWake ((int) reg4, (int) reg5);
+    break;
+  case SC_FutexAdd:
+    returnvalue = System_FutexAdd ((int) reg4, (int) reg5);
+    break;
 
 /* ---------------------------------------------------------- */
   case SC_NachosUserEvent:
@@ -298,6 +310,30 @@ int System_Close (int fd) {
 }
 
 
+// ================================================================
+// System_Fsync:
+// Parameters: register 4 holds the file descriptor.
+// Returns: 0 once the file's writes are on the disk, or -EBADF.
+// The cache does not know which file a sector belongs to, so every
+// dirty sector is written; with a write-through cache (or the stub
+// file system) there is nothing to wait for.
+// ================================================================
+int System_Fsync (int fd) {
+  FDTEntry *fdte = (fd >= 0) ? currentThread->getFD (fd) : NULL;
+
+  if (!fdte || (fdte->type != ConsoleFile && fdte->type != DiskFile)) {
+    return -EBADF;
+  }
+  stats->numFsyncs++;
+#ifdef FILESYS
+  if (fdte->type == DiskFile) {
+    synchDisk->Sync ();
+  }
+#endif
+  return 0;
+}
+
+
 //
 //
 int System_Unlink (char *user_space_filename) {
@@ -443,7 +479,7 @@ int System_Exec (char * user_space_filename) {
     return -ENOENT;
   }
 
-  ret = currentThread->space->ModifySpace(executable);
+  ret = currentThread->space->ModifySpace(executable, filename);
   //  delete executable;                  // close file
   delete [] filename;
 
@@ -577,8 +613,7 @@ void Do_Fork(size_t dummy) {
   dummy = 0;  // Keep gcc happy; the mechanism we use to call this only works
 	      // with functions that take 1 size_t argument
   
-  currentThread->RestoreUserState();
-  currentThread->space->RestoreState();
+  currentThread->RestoreUserContext();
 
   /* Executed by the child process.  Sets the registers to the state they
      would have if the operating system was executing on the real hardware,
@@ -693,4 +728,99 @@ int System_Echo (char * from_user_space, int num_to_write) {
   return byteswritten;
 }
 
+
+// ================================================================
+// Futex words:
+// The kernel keeps NumFutexes words, all starting at 0, that every
+// process shares; a futex is named by its number.  (Processes share
+// no memory, and the simulated CPU has no atomic instructions, so a
+// word that more than one process can change has to live here.)
+// Each word has a FIFO of the threads sleeping on it.
+// ================================================================
+static int futexWords[NumFutexes];
+static List futexWaiters[NumFutexes];
+
+
+// ================================================================
+// System_FutexWait:
+// Parameters: register 4 holds the futex number, register 5 the
+//             value the caller expects its word to hold.
+// Returns: 0 once woken by FutexWake; -EAGAIN at once if the word no
+//          longer holds the value (it changed before we could sleep);
+//          -EINVAL for a bad futex number.
+// The check and the sleep are one atomic step, with interrupts off,
+// so a wake that follows the change of the word cannot be missed.
+// ================================================================
+int System_FutexWait (int futex, int val) {
+  if (futex < 0 || futex >= NumFutexes) {
+    return -EINVAL;
+  }
+
+  IntStatus oldLevel = interrupt->SetLevel (IntOff);
+  if (futexWords[futex] != val) {
+    (void) interrupt->SetLevel (oldLevel);
+    return -EAGAIN;
+  }
+  futexWaiters[futex].Append (currentThread);
+  currentThread->Sleep ();
+  (void) interrupt->SetLevel (oldLevel);
+  return 0;
+}
+
+
+// ================================================================
+// System_FutexWake:
+// Parameters: register 4 holds the futex number, register 5 the most
+//             sleepers to wake.
+// Returns: the number of threads woken, oldest sleeper first, from
+//          any process; -EINVAL for a bad futex number.
+// ================================================================
+int System_FutexWake (int futex, int count) {
+  Thread *thread;
+  int woken = 0;
+
+  if (futex < 0 || futex >= NumFutexes) {
+    return -EINVAL;
+  }
+
+  IntStatus oldLevel = interrupt->SetLevel (IntOff);
+  while (woken < count &&
+	 (thread = static_cast<Thread *>(futexWaiters[futex].Remove ())) != NULL) {
+    scheduler->ReadyToRun (thread);
+    woken++;
+  }
+  (void) interrupt->SetLevel (oldLevel);
+  return woken;
+}
+
+
+// ================================================================
+// System_FutexAdd:
+// Parameters: register 4 holds the futex number, register 5 the
+//             amount to add to its word.
+// Returns: the new value of the word; -EAGAIN, leaving the word
+//          alone, if it would go below 0; -EINVAL for a bad futex
+//          number.  A word that never goes negative makes a
+//          counting semaphore: down is FutexAdd (f, -1), with a
+//          FutexWait (f, 0) and a retry when it fails, and up is
+//          FutexAdd (f, 1) followed by FutexWake (f, 1).
+// ================================================================
+int System_FutexAdd (int futex, int delta) {
+  int result;
+
+  if (futex < 0 || futex >= NumFutexes) {
+    return -EINVAL;
+  }
+
+  IntStatus oldLevel = interrupt->SetLevel (IntOff);
+  result = futexWords[futex] + delta;
+  if (result < 0) {
+    result = -EAGAIN;
+  } else {
+    futexWords[futex] = result;
+  }
+  (void) interrupt->SetLevel (oldLevel);
+  return result;
+}
+
 #endif /* USER_PROGRAM */
@@ -22,6 +22,7 @@ extern int System_Wait (int *exitvalue);   //not done
 extern int System_Create (char *user_space_filename);
 extern int System_Open (char *user_space_filename);
 extern int System_Close (int fd);
+extern int System_Fsync (int fd);
 extern int System_Unlink (char *user_space_filename);
 extern int System_GetPID (void);
 extern int System_GetPPID (void);
@@ -37,6 +38,9 @@ extern int System_Echo (char * from_user_space, int num_to_write);
 extern void System_Nice (int inc);
 
 extern int System_NameThread (char *name);
+extern int System_FutexWait (int futex, int val);
+extern int System_FutexWake (int futex, int count);
+extern int System_FutexAdd (int futex, int delta);
 
 extern int copy_from_user (char * from_user_space, char * to_k_space);
 extern void Do_Fork (size_t dummy);